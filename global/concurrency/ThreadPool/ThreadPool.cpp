@@ -0,0 +1,136 @@
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <exception>
+
+namespace tin
+{
+    ThreadPool::ThreadPool(size_t threads) : stopping(false)
+    {
+        if (threads == 0)
+        {
+            threads = 1;
+        }
+
+        for (size_t i = 0; i < threads; i++)
+        {
+            workers.emplace_back(&ThreadPool::run, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        available.notify_all();
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool &ThreadPool::shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void ThreadPool::enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        available.notify_one();
+    }
+
+    void ThreadPool::run()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                available.wait(lock, [this]()
+                               { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty())
+                    return;
+
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    void ThreadPool::parallelFor(size_t first, size_t last, size_t grain, const std::function<void(size_t, size_t)> &body)
+    {
+        if (first >= last)
+            return;
+        if (grain == 0)
+            grain = 1;
+
+        size_t chunks = (last - first + grain - 1) / grain;
+        if (chunks == 1)
+        {
+            body(first, last);
+            return;
+        }
+
+        // Helpers may start after the caller has finished every chunk, so the
+        // shared state outlives this call.
+        struct Loop
+        {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+            std::mutex mutex;
+            std::condition_variable finished;
+            std::exception_ptr error;
+        };
+        auto loop = std::make_shared<Loop>();
+
+        auto work = [loop, first, last, grain, chunks, &body]()
+        {
+            size_t chunk;
+            while ((chunk = loop->next.fetch_add(1)) < chunks)
+            {
+                size_t begin = first + chunk * grain;
+                try
+                {
+                    body(begin, std::min(last, begin + grain));
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(loop->mutex);
+                    if (!loop->error)
+                        loop->error = std::current_exception();
+                }
+
+                if (loop->done.fetch_add(1) + 1 == chunks)
+                {
+                    std::lock_guard<std::mutex> lock(loop->mutex);
+                    loop->finished.notify_all();
+                }
+            }
+        };
+
+        size_t helpers = std::min(chunks - 1, workers.size());
+        for (size_t i = 0; i < helpers; i++)
+        {
+            // `body` is only touched while a chunk is claimed, and the caller
+            // waits for every claimed chunk, so the reference stays valid.
+            enqueue(work);
+        }
+        work();
+
+        std::unique_lock<std::mutex> lock(loop->mutex);
+        loop->finished.wait(lock, [&]()
+                            { return loop->done.load() == chunks; });
+        if (loop->error)
+        {
+            std::rethrow_exception(loop->error);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace tin
+{
+    /**
+     * Fixed set of worker threads fed from one FIFO queue. parallelFor() has
+     * the calling thread take chunks too, so it makes progress (and cannot
+     * deadlock) even when every worker is busy, including when called from
+     * inside a task.
+     */
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        template <typename Func>
+        std::future<typename std::invoke_result<Func>::type> submit(Func func);
+
+        // Runs body(begin, end) over [first, last) in chunks of at most `grain`
+        // and returns once every chunk is done. The first exception thrown by
+        // a chunk is rethrown here.
+        void parallelFor(size_t first, size_t last, size_t grain, const std::function<void(size_t, size_t)> &body);
+
+        size_t size() const { return workers.size(); }
+
+        static ThreadPool &shared();
+
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable available;
+        bool stopping;
+
+        void enqueue(std::function<void()> task);
+        void run();
+    };
+}
+
+#include "ThreadPool.tpp"
+#include "ThreadPool.cpp"
+
+#endif // THREADPOOL_HPP
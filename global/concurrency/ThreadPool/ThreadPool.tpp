@@ -0,0 +1,16 @@
+#include "ThreadPool.hpp"
+
+namespace tin
+{
+    template <typename Func>
+    std::future<typename std::invoke_result<Func>::type> ThreadPool::submit(Func func)
+    {
+        typedef typename std::invoke_result<Func>::type Result;
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+        std::future<Result> result = task->get_future();
+        enqueue([task]()
+                { (*task)(); });
+        return result;
+    }
+}
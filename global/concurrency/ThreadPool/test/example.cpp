@@ -0,0 +1,54 @@
+#include "../ThreadPool.hpp"
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+
+int main()
+{
+    tin::ThreadPool pool(4);
+
+    // submit returns the task's value through a future
+    auto answer = pool.submit([]()
+                              { return 6 * 7; });
+    assert(answer.get() == 42);
+
+    // parallelFor covers every index exactly once
+    std::vector<std::atomic<int>> hits(10000);
+    pool.parallelFor(0, hits.size(), 64, [&](size_t begin, size_t end)
+                     {
+        for (size_t i = begin; i < end; i++)
+        {
+            hits[i]++;
+        } });
+    for (auto &hit : hits)
+    {
+        assert(hit == 1);
+    }
+
+    // Nested loops run on the caller when the workers are busy
+    std::atomic<size_t> total(0);
+    pool.parallelFor(0, 8, 1, [&](size_t, size_t)
+                     { pool.parallelFor(0, 100, 10, [&](size_t begin, size_t end)
+                                        { total += end - begin; }); });
+    assert(total == 800);
+
+    // Exceptions surface in the caller
+    bool caught = false;
+    try
+    {
+        pool.parallelFor(0, 100, 1, [](size_t begin, size_t)
+                         {
+            if (begin == 50)
+                throw std::runtime_error("chunk 50"); });
+    }
+    catch (const std::runtime_error &e)
+    {
+        caught = true;
+    }
+    assert(caught);
+
+    std::cout << "All ThreadPool tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,467 @@
+#include "BLAKE3.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+namespace tin
+{
+    constexpr size_t BLAKE3::DIGEST_LENGTH;
+    constexpr size_t BLAKE3::KEY_LENGTH;
+    constexpr size_t BLAKE3::BLOCK_LENGTH;
+    constexpr size_t BLAKE3::CHUNK_LENGTH;
+    constexpr std::array<uint32_t, 8> BLAKE3::IV;
+
+    // Message word order for each of the seven rounds
+    const uint8_t BLAKE3::MSG_SCHEDULE[7][16] = {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+        {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+        {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+        {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+        {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+        {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+        {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13}};
+
+    namespace blake3_portable
+    {
+        inline uint32_t rotate(uint32_t x, uint32_t n)
+        {
+            return (x >> n) | (x << (32 - n));
+        }
+
+        inline uint32_t loadWord(const uint8_t *p)
+        {
+            return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+        }
+
+        inline void g(uint32_t *v, int a, int b, int c, int d, uint32_t x, uint32_t y)
+        {
+            v[a] = v[a] + v[b] + x;
+            v[d] = rotate(v[d] ^ v[a], 16);
+            v[c] = v[c] + v[d];
+            v[b] = rotate(v[b] ^ v[c], 12);
+            v[a] = v[a] + v[b] + y;
+            v[d] = rotate(v[d] ^ v[a], 8);
+            v[c] = v[c] + v[d];
+            v[b] = rotate(v[b] ^ v[c], 7);
+        }
+    }
+
+    void BLAKE3::compress(const uint32_t *cv, const uint8_t *block, uint8_t blockLen, uint64_t counter, uint8_t flags, uint32_t *out)
+    {
+        using namespace blake3_portable;
+
+        uint32_t m[16];
+        for (int i = 0; i < 16; i++)
+        {
+            m[i] = loadWord(block + i * 4);
+        }
+
+        uint32_t v[16] = {cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+                          IV[0], IV[1], IV[2], IV[3],
+                          uint32_t(counter), uint32_t(counter >> 32), blockLen, flags};
+
+        for (int r = 0; r < 7; r++)
+        {
+            const uint8_t *s = MSG_SCHEDULE[r];
+            g(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+            g(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+            g(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+            g(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+            g(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+            g(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+            g(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+            g(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+        }
+
+        for (int i = 0; i < 8; i++)
+        {
+            out[i] = v[i] ^ v[i + 8];
+        }
+    }
+
+    void BLAKE3::storeWords(const uint32_t *words, uint8_t *bytes)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            bytes[i * 4] = words[i];
+            bytes[i * 4 + 1] = words[i] >> 8;
+            bytes[i * 4 + 2] = words[i] >> 16;
+            bytes[i * 4 + 3] = words[i] >> 24;
+        }
+    }
+
+    void BLAKE3::hashManyPortable(const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+                                  uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t flagsStart,
+                                  uint8_t flagsEnd, uint8_t *out)
+    {
+        for (size_t i = 0; i < count; i++, out += DIGEST_LENGTH)
+        {
+            uint32_t cv[8];
+            std::memcpy(cv, key, sizeof(cv));
+
+            for (size_t b = 0; b < blocks; b++)
+            {
+                uint8_t blockFlags = flags | (b == 0 ? flagsStart : 0) | (b + 1 == blocks ? flagsEnd : 0);
+                compress(cv, inputs[i] + b * BLOCK_LENGTH, BLOCK_LENGTH, counter, blockFlags, cv);
+            }
+
+            storeWords(cv, out);
+            if (incrementCounter)
+                counter++;
+        }
+    }
+
+    bool BLAKE3::isSupported(Implementation impl)
+    {
+        switch (impl)
+        {
+        case PORTABLE:
+            return true;
+#ifdef TIN_SHA256_X86
+        case SSE2:
+            return true;
+        case AVX2:
+            // Same CPUID/XCR0 check the SHA256 kernels rely on
+            return SHA256::isSupported(SHA256::AVX2);
+#endif
+        default:
+            return false;
+        }
+    }
+
+    BLAKE3::HashManyFunc BLAKE3::kernel(Implementation impl)
+    {
+        switch (impl)
+        {
+#ifdef TIN_SHA256_X86
+        case SSE2:
+            return &BLAKE3::hashManySSE2;
+        case AVX2:
+            return &BLAKE3::hashManyAVX2;
+#endif
+        default:
+            return &BLAKE3::hashManyPortable;
+        }
+    }
+
+    std::atomic<BLAKE3::HashManyFunc> &BLAKE3::dispatch()
+    {
+        static std::atomic<HashManyFunc> func(kernel(isSupported(AVX2) ? AVX2 : isSupported(SSE2) ? SSE2
+                                                                                                  : PORTABLE));
+        return func;
+    }
+
+    BLAKE3::Implementation BLAKE3::implementation()
+    {
+        HashManyFunc current = dispatch().load(std::memory_order_relaxed);
+        for (Implementation impl : {AVX2, SSE2})
+        {
+            if (current == kernel(impl))
+                return impl;
+        }
+        return PORTABLE;
+    }
+
+    void BLAKE3::setImplementation(Implementation impl)
+    {
+        if (!isSupported(impl))
+        {
+            throw std::invalid_argument(std::string("BLAKE3 implementation not supported: ") + implementationName(impl));
+        }
+        dispatch().store(kernel(impl), std::memory_order_relaxed);
+    }
+
+    const char *BLAKE3::implementationName(Implementation impl)
+    {
+        switch (impl)
+        {
+        case SSE2:
+            return "sse2";
+        case AVX2:
+            return "avx2";
+        default:
+            return "portable";
+        }
+    }
+
+    size_t BLAKE3::lanes()
+    {
+        switch (implementation())
+        {
+        case AVX2:
+            return 8;
+        case SSE2:
+            return 4;
+        default:
+            return 1;
+        }
+    }
+
+    void BLAKE3::hashChunks(const uint8_t *input, size_t chunks, const uint32_t *key, uint64_t counter, uint8_t flags, uint8_t *cvs)
+    {
+        const uint8_t *inputs[16];
+        HashManyFunc hashMany = dispatch().load(std::memory_order_relaxed);
+
+        for (size_t done = 0; done < chunks;)
+        {
+            size_t batch = std::min<size_t>(16, chunks - done);
+            for (size_t i = 0; i < batch; i++)
+            {
+                inputs[i] = input + (done + i) * CHUNK_LENGTH;
+            }
+            hashMany(inputs, batch, CHUNK_LENGTH / BLOCK_LENGTH, key, counter + done, true,
+                     flags, CHUNK_START, CHUNK_END, cvs + done * DIGEST_LENGTH);
+            done += batch;
+        }
+    }
+
+    void BLAKE3::hashParents(const uint8_t *children, size_t parents, const uint32_t *key, uint8_t flags, uint8_t *cvs)
+    {
+        const uint8_t *inputs[16];
+        HashManyFunc hashMany = dispatch().load(std::memory_order_relaxed);
+
+        for (size_t done = 0; done < parents;)
+        {
+            size_t batch = std::min<size_t>(16, parents - done);
+            for (size_t i = 0; i < batch; i++)
+            {
+                inputs[i] = children + (done + i) * 2 * DIGEST_LENGTH;
+            }
+            hashMany(inputs, batch, 1, key, 0, false, flags | PARENT, 0, 0, cvs + done * DIGEST_LENGTH);
+            done += batch;
+        }
+    }
+
+    void BLAKE3::ChunkState::reset(const uint32_t *key, uint64_t chunkCounter, uint8_t baseFlags)
+    {
+        std::memcpy(cv, key, sizeof(cv));
+        std::memset(block, 0, sizeof(block));
+        counter = chunkCounter;
+        blockLen = 0;
+        blocksCompressed = 0;
+        flags = baseFlags;
+    }
+
+    size_t BLAKE3::ChunkState::length() const
+    {
+        return size_t(blocksCompressed) * BLOCK_LENGTH + blockLen;
+    }
+
+    uint8_t BLAKE3::ChunkState::startFlag() const
+    {
+        return blocksCompressed == 0 ? CHUNK_START : 0;
+    }
+
+    void BLAKE3::ChunkState::update(const uint8_t *input, size_t length)
+    {
+        while (length > 0)
+        {
+            // The last block is kept back: it may need CHUNK_END and ROOT
+            if (blockLen == BLOCK_LENGTH)
+            {
+                compress(cv, block, BLOCK_LENGTH, counter, flags | startFlag(), cv);
+                blocksCompressed++;
+                std::memset(block, 0, sizeof(block));
+                blockLen = 0;
+            }
+
+            size_t take = std::min(BLOCK_LENGTH - blockLen, length);
+            std::memcpy(block + blockLen, input, take);
+            blockLen += take;
+            input += take;
+            length -= take;
+        }
+    }
+
+    void BLAKE3::init(const uint32_t *keyWords, uint8_t baseFlags)
+    {
+        std::memcpy(key, keyWords, sizeof(key));
+        flags = baseFlags;
+        cvStackLen = 0;
+        chunk.reset(key, 0, flags);
+    }
+
+    BLAKE3::BLAKE3()
+    {
+        init(IV.data(), 0);
+    }
+
+    BLAKE3::BLAKE3(const std::array<uint8_t, KEY_LENGTH> &keyBytes)
+    {
+        uint32_t words[8];
+        for (int i = 0; i < 8; i++)
+        {
+            words[i] = blake3_portable::loadWord(keyBytes.data() + i * 4);
+        }
+        init(words, KEYED_HASH);
+    }
+
+    // Merges completed subtrees: after chunk n, one merge per trailing zero bit of n
+    void BLAKE3::pushChunkCV(const uint32_t *cv, uint64_t totalChunks)
+    {
+        uint32_t merged[8];
+        std::memcpy(merged, cv, sizeof(merged));
+
+        while ((totalChunks & 1) == 0)
+        {
+            uint8_t block[BLOCK_LENGTH];
+            storeWords(cvStack[--cvStackLen], block);
+            storeWords(merged, block + DIGEST_LENGTH);
+            compress(key, block, BLOCK_LENGTH, 0, flags | PARENT, merged);
+            totalChunks >>= 1;
+        }
+
+        std::memcpy(cvStack[cvStackLen++], merged, sizeof(merged));
+    }
+
+    BLAKE3 &BLAKE3::update(const uint8_t *input, size_t length)
+    {
+        while (length > 0)
+        {
+            if (chunk.length() == CHUNK_LENGTH)
+            {
+                uint32_t cv[8];
+                compress(chunk.cv, chunk.block, chunk.blockLen, chunk.counter, chunk.flags | chunk.startFlag() | CHUNK_END, cv);
+                pushChunkCV(cv, chunk.counter + 1);
+                chunk.reset(key, chunk.counter + 1, flags);
+            }
+
+            // Whole chunks go through the SIMD lanes, keeping at least one
+            // byte back for the chunk that may turn out to be the root
+            if (chunk.length() == 0 && length > CHUNK_LENGTH)
+            {
+                size_t chunks = std::min<size_t>((length - 1) / CHUNK_LENGTH, 16);
+                uint8_t cvs[16 * DIGEST_LENGTH];
+                hashChunks(input, chunks, key, chunk.counter, flags, cvs);
+
+                for (size_t i = 0; i < chunks; i++)
+                {
+                    uint32_t cv[8];
+                    for (int j = 0; j < 8; j++)
+                    {
+                        cv[j] = blake3_portable::loadWord(cvs + i * DIGEST_LENGTH + j * 4);
+                    }
+                    pushChunkCV(cv, chunk.counter + i + 1);
+                }
+
+                chunk.reset(key, chunk.counter + chunks, flags);
+                input += chunks * CHUNK_LENGTH;
+                length -= chunks * CHUNK_LENGTH;
+                continue;
+            }
+
+            size_t take = std::min(CHUNK_LENGTH - chunk.length(), length);
+            chunk.update(input, take);
+            input += take;
+            length -= take;
+        }
+        return *this;
+    }
+
+    BLAKE3 &BLAKE3::update(ByteView data)
+    {
+        return update(data.data, data.size);
+    }
+
+    BLAKE3 &BLAKE3::update(const std::string &data)
+    {
+        return update(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+    }
+
+    BLAKE3 &BLAKE3::update(const std::vector<uint8_t> &data)
+    {
+        return update(data.data(), data.size());
+    }
+
+    BLAKE3 &BLAKE3::update(const std::array<uint8_t, DIGEST_LENGTH> &data)
+    {
+        return update(data.data(), data.size());
+    }
+
+    std::array<uint8_t, BLAKE3::DIGEST_LENGTH> BLAKE3::digest()
+    {
+        std::array<uint8_t, DIGEST_LENGTH> hash;
+        uint32_t out[8];
+        uint8_t chunkFlags = chunk.flags | chunk.startFlag() | CHUNK_END;
+
+        if (cvStackLen == 0)
+        {
+            compress(chunk.cv, chunk.block, chunk.blockLen, chunk.counter, chunkFlags | ROOT, out);
+            storeWords(out, hash.data());
+            return hash;
+        }
+
+        uint32_t right[8];
+        compress(chunk.cv, chunk.block, chunk.blockLen, chunk.counter, chunkFlags, right);
+
+        uint8_t block[BLOCK_LENGTH];
+        for (size_t i = cvStackLen; i-- > 0;)
+        {
+            storeWords(cvStack[i], block);
+            storeWords(right, block + DIGEST_LENGTH);
+            compress(key, block, BLOCK_LENGTH, 0, flags | PARENT | (i == 0 ? ROOT : 0), right);
+        }
+
+        storeWords(right, hash.data());
+        return hash;
+    }
+
+    std::string BLAKE3::toString(const std::array<uint8_t, DIGEST_LENGTH> &digest)
+    {
+        return SHA256::toString(digest);
+    }
+
+    std::array<uint8_t, BLAKE3::DIGEST_LENGTH> BLAKE3::hashParallel(ByteView data, ThreadPool &pool)
+    {
+        if (data.size <= CHUNK_LENGTH)
+        {
+            return BLAKE3().update(data).digest();
+        }
+
+        // Chaining values of every chunk, then one tree level at a time. An
+        // odd node at the end of a level is carried up unchanged, which gives
+        // the same left-balanced tree as the incremental hasher.
+        const size_t GRAIN = 64;
+        size_t chunks = (data.size + CHUNK_LENGTH - 1) / CHUNK_LENGTH;
+        size_t fullChunks = data.size / CHUNK_LENGTH;
+        std::vector<uint8_t> level(chunks * DIGEST_LENGTH);
+        std::vector<uint8_t> next(((chunks + 1) / 2) * DIGEST_LENGTH);
+
+        pool.parallelFor(0, chunks, GRAIN, [&](size_t begin, size_t end)
+                         {
+            size_t fullEnd = std::min(end, fullChunks);
+            if (begin < fullEnd)
+            {
+                hashChunks(data.data + begin * CHUNK_LENGTH, fullEnd - begin, IV.data(), begin, 0, level.data() + begin * DIGEST_LENGTH);
+            }
+            if (end > fullEnd)
+            {
+                ChunkState last;
+                last.reset(IV.data(), fullChunks, 0);
+                last.update(data.data + fullChunks * CHUNK_LENGTH, data.size - fullChunks * CHUNK_LENGTH);
+                uint32_t cv[8];
+                compress(last.cv, last.block, last.blockLen, last.counter, last.startFlag() | CHUNK_END, cv);
+                storeWords(cv, level.data() + fullChunks * DIGEST_LENGTH);
+            } });
+
+        size_t count = chunks;
+        while (count > 2)
+        {
+            size_t parents = count / 2;
+            pool.parallelFor(0, parents, GRAIN * 4, [&](size_t begin, size_t end)
+                             { hashParents(level.data() + begin * 2 * DIGEST_LENGTH, end - begin, IV.data(), 0, next.data() + begin * DIGEST_LENGTH); });
+            if (count % 2)
+            {
+                std::memcpy(next.data() + parents * DIGEST_LENGTH, level.data() + (count - 1) * DIGEST_LENGTH, DIGEST_LENGTH);
+            }
+            count = parents + count % 2;
+            level.swap(next);
+        }
+
+        uint32_t root[8];
+        compress(IV.data(), level.data(), BLOCK_LENGTH, 0, PARENT | ROOT, root);
+        std::array<uint8_t, DIGEST_LENGTH> hash;
+        storeWords(root, hash.data());
+        return hash;
+    }
+}
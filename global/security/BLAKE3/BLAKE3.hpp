@@ -0,0 +1,125 @@
+#ifndef BLAKE3_HPP
+#define BLAKE3_HPP
+
+#include "../SHA256/SHA256.hpp"
+#include "../../concurrency/ThreadPool/ThreadPool.hpp"
+#include <string>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace tin
+{
+    /**
+     * BLAKE3 with 32-byte output, for integrity checks that are not consensus
+     * critical. It has the same update()/digest()/toString() shape as
+     * tin::SHA256, so code templated on the hasher can use either.
+     *
+     * Whole chunks handed to update() are compressed several at a time in
+     * SIMD lanes (4 with SSE2, 8 with AVX2). hashParallel() additionally
+     * spreads the chunks of one large input over a thread pool.
+     */
+    class BLAKE3
+    {
+    public:
+        static constexpr size_t DIGEST_LENGTH = 32;
+        static constexpr size_t KEY_LENGTH = 32;
+        static constexpr size_t BLOCK_LENGTH = 64;
+        static constexpr size_t CHUNK_LENGTH = 1024;
+        static constexpr std::array<uint32_t, 8> IV = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        static const uint8_t MSG_SCHEDULE[7][16];
+
+        enum Implementation
+        {
+            PORTABLE,
+            SSE2,
+            AVX2
+        };
+
+        enum Flags : uint8_t
+        {
+            CHUNK_START = 1 << 0,
+            CHUNK_END = 1 << 1,
+            PARENT = 1 << 2,
+            ROOT = 1 << 3,
+            KEYED_HASH = 1 << 4
+        };
+
+    private:
+        typedef void (*HashManyFunc)(const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+                                     uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t flagsStart,
+                                     uint8_t flagsEnd, uint8_t *out);
+
+        // The chunk currently being filled
+        struct ChunkState
+        {
+            uint32_t cv[8];
+            uint64_t counter;
+            uint8_t block[BLOCK_LENGTH];
+            uint8_t blockLen;
+            uint8_t blocksCompressed;
+            uint8_t flags;
+
+            void reset(const uint32_t *key, uint64_t chunkCounter, uint8_t baseFlags);
+            size_t length() const;
+            uint8_t startFlag() const;
+            void update(const uint8_t *input, size_t length);
+        };
+
+        uint32_t key[8];
+        uint8_t flags;
+        ChunkState chunk;
+        uint32_t cvStack[54][8];
+        uint8_t cvStackLen;
+
+        static void compress(const uint32_t *cv, const uint8_t *block, uint8_t blockLen, uint64_t counter, uint8_t flags, uint32_t *out);
+        static void hashManyPortable(const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+                                     uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t flagsStart,
+                                     uint8_t flagsEnd, uint8_t *out);
+#ifdef TIN_SHA256_X86
+        static void hashManySSE2(const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+                                 uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t flagsStart,
+                                 uint8_t flagsEnd, uint8_t *out);
+        static void hashManyAVX2(const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+                                 uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t flagsStart,
+                                 uint8_t flagsEnd, uint8_t *out);
+#endif
+        static HashManyFunc kernel(Implementation impl);
+        static std::atomic<HashManyFunc> &dispatch();
+        static void hashChunks(const uint8_t *input, size_t chunks, const uint32_t *key, uint64_t counter, uint8_t flags, uint8_t *cvs);
+        static void hashParents(const uint8_t *children, size_t parents, const uint32_t *key, uint8_t flags, uint8_t *cvs);
+        static void storeWords(const uint32_t *words, uint8_t *bytes);
+
+        void pushChunkCV(const uint32_t *cv, uint64_t totalChunks);
+        void init(const uint32_t *keyWords, uint8_t baseFlags);
+
+    public:
+        BLAKE3();
+        explicit BLAKE3(const std::array<uint8_t, KEY_LENGTH> &key);
+
+        BLAKE3 &update(const uint8_t *input, size_t length);
+        BLAKE3 &update(ByteView data);
+        BLAKE3 &update(const std::string &data);
+        BLAKE3 &update(const std::vector<uint8_t> &data);
+        BLAKE3 &update(const std::array<uint8_t, DIGEST_LENGTH> &data);
+        std::array<uint8_t, DIGEST_LENGTH> digest();
+        static std::string toString(const std::array<uint8_t, DIGEST_LENGTH> &digest);
+
+        // One-shot tree hash of a large input using every thread in `pool`
+        static std::array<uint8_t, DIGEST_LENGTH> hashParallel(ByteView data, ThreadPool &pool = ThreadPool::shared());
+
+        static bool isSupported(Implementation impl);
+        static Implementation implementation();
+        static void setImplementation(Implementation impl);
+        static const char *implementationName(Implementation impl);
+        static size_t lanes();
+    };
+}
+
+#include "BLAKE3.cpp"
+#include "BLAKE3x86.cpp"
+
+#endif // BLAKE3_HPP
@@ -0,0 +1,133 @@
+#include "BLAKE3.hpp"
+
+#ifdef TIN_SHA256_X86
+
+#include <cstring>
+
+namespace tin
+{
+    namespace blake3_x86
+    {
+        typedef uint32_t u32x4 __attribute__((vector_size(16)));
+        typedef uint32_t u32x8 __attribute__((vector_size(32)));
+
+        // A macro rather than a function: returning a 256-bit vector from a
+        // function without AVX enabled changes the ABI and GCC warns about it.
+#define TIN_BLAKE3_LANE_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define TIN_BLAKE3_LANE_G(a, b, c, d, x, y)                \
+    do                                                     \
+    {                                                      \
+        v[a] += v[b] + (x);                                \
+        v[d] = TIN_BLAKE3_LANE_ROR(v[d] ^ v[a], 16);       \
+        v[c] += v[d];                                      \
+        v[b] = TIN_BLAKE3_LANE_ROR(v[b] ^ v[c], 12);       \
+        v[a] += v[b] + (y);                                \
+        v[d] = TIN_BLAKE3_LANE_ROR(v[d] ^ v[a], 8);        \
+        v[c] += v[d];                                      \
+        v[b] = TIN_BLAKE3_LANE_ROR(v[b] ^ v[c], 7);        \
+    } while (0)
+
+        // Runs L inputs of `blocks` blocks each side by side, one input per
+        // lane. Lane i uses chunk counter `counter + i` when incrementCounter
+        // is set, otherwise they all share `counter` (parent nodes).
+        template <typename V, size_t L>
+        __attribute__((always_inline)) inline void hashLanes(const uint8_t *const *inputs, size_t blocks, const uint32_t *key,
+                                                             uint64_t counter, bool incrementCounter, uint8_t flags,
+                                                             uint8_t flagsStart, uint8_t flagsEnd, uint8_t *out)
+        {
+            V h[8];
+            for (int i = 0; i < 8; i++)
+            {
+                h[i] = V{} + key[i];
+            }
+
+            V counterLow, counterHigh;
+            for (size_t i = 0; i < L; i++)
+            {
+                uint64_t c = counter + (incrementCounter ? i : 0);
+                counterLow[i] = uint32_t(c);
+                counterHigh[i] = uint32_t(c >> 32);
+            }
+
+            for (size_t b = 0; b < blocks; b++)
+            {
+                V m[16];
+                for (size_t i = 0; i < L; i++)
+                {
+                    uint32_t words[16];
+                    std::memcpy(words, inputs[i] + b * BLAKE3::BLOCK_LENGTH, sizeof(words));
+                    for (int j = 0; j < 16; j++)
+                    {
+                        m[j][i] = words[j];
+                    }
+                }
+
+                uint32_t blockFlags = flags | (b == 0 ? flagsStart : 0) | (b + 1 == blocks ? flagsEnd : 0);
+                V v[16] = {h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+                           V{} + BLAKE3::IV[0], V{} + BLAKE3::IV[1], V{} + BLAKE3::IV[2], V{} + BLAKE3::IV[3],
+                           counterLow, counterHigh, V{} + uint32_t(BLAKE3::BLOCK_LENGTH), V{} + blockFlags};
+
+                for (int r = 0; r < 7; r++)
+                {
+                    const uint8_t *s = BLAKE3::MSG_SCHEDULE[r];
+                    TIN_BLAKE3_LANE_G(0, 4, 8, 12, m[s[0]], m[s[1]]);
+                    TIN_BLAKE3_LANE_G(1, 5, 9, 13, m[s[2]], m[s[3]]);
+                    TIN_BLAKE3_LANE_G(2, 6, 10, 14, m[s[4]], m[s[5]]);
+                    TIN_BLAKE3_LANE_G(3, 7, 11, 15, m[s[6]], m[s[7]]);
+                    TIN_BLAKE3_LANE_G(0, 5, 10, 15, m[s[8]], m[s[9]]);
+                    TIN_BLAKE3_LANE_G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+                    TIN_BLAKE3_LANE_G(2, 7, 8, 13, m[s[12]], m[s[13]]);
+                    TIN_BLAKE3_LANE_G(3, 4, 9, 14, m[s[14]], m[s[15]]);
+                }
+
+                for (int i = 0; i < 8; i++)
+                {
+                    h[i] = v[i] ^ v[i + 8];
+                }
+            }
+
+            for (size_t i = 0; i < L; i++)
+            {
+                uint32_t words[8];
+                for (int j = 0; j < 8; j++)
+                {
+                    words[j] = h[j][i];
+                }
+                std::memcpy(out + i * BLAKE3::DIGEST_LENGTH, words, sizeof(words));
+            }
+        }
+
+#undef TIN_BLAKE3_LANE_G
+#undef TIN_BLAKE3_LANE_ROR
+    }
+
+    // x86 is little-endian, so message and output words are plain memcpys
+
+    __attribute__((target("sse2"))) void BLAKE3::hashManySSE2(const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+                                                              uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t flagsStart,
+                                                              uint8_t flagsEnd, uint8_t *out)
+    {
+        for (; count >= 4; count -= 4, inputs += 4, out += 4 * DIGEST_LENGTH)
+        {
+            blake3_x86::hashLanes<blake3_x86::u32x4, 4>(inputs, blocks, key, counter, incrementCounter, flags, flagsStart, flagsEnd, out);
+            if (incrementCounter)
+                counter += 4;
+        }
+        hashManyPortable(inputs, count, blocks, key, counter, incrementCounter, flags, flagsStart, flagsEnd, out);
+    }
+
+    __attribute__((target("avx2"))) void BLAKE3::hashManyAVX2(const uint8_t *const *inputs, size_t count, size_t blocks, const uint32_t *key,
+                                                              uint64_t counter, bool incrementCounter, uint8_t flags, uint8_t flagsStart,
+                                                              uint8_t flagsEnd, uint8_t *out)
+    {
+        for (; count >= 8; count -= 8, inputs += 8, out += 8 * DIGEST_LENGTH)
+        {
+            blake3_x86::hashLanes<blake3_x86::u32x8, 8>(inputs, blocks, key, counter, incrementCounter, flags, flagsStart, flagsEnd, out);
+            if (incrementCounter)
+                counter += 8;
+        }
+        hashManySSE2(inputs, count, blocks, key, counter, incrementCounter, flags, flagsStart, flagsEnd, out);
+    }
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include "../BLAKE3.hpp"
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <string>
+#include <cstring>
+
+// Inputs are bytes i % 251, as in the official BLAKE3 test vectors
+static std::vector<uint8_t> vectorInput(size_t length)
+{
+    std::vector<uint8_t> bytes(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        bytes[i] = i % 251;
+    }
+    return bytes;
+}
+
+static const std::pair<size_t, const char *> VECTORS[] = {
+    {0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+    {1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+    {63, "e9bc37a594daad83be9470df7f7b3798297c3d834ce80ba85d6e207627b7db7b"},
+    {64, "4eed7141ea4a5cd4b788606bd23f46e212af9cacebacdc7d1f4c6dc7f2511b98"},
+    {65, "de1e5fa0be70df6d2be8fffd0e99ceaa8eb6e8c93a63f2d8d1c30ecb6b263dee"},
+    {1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"},
+    {1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+    {1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+    {2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a"},
+    {2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"},
+    {3072, "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2"},
+    {3073, "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3"},
+    {4096, "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969"},
+    {4097, "9b4052b38f1c5fc8b1f9ff7ac7b27cd242487b3d890d15c96a1c25b8aa0fb995"},
+    {5121, "628bd2cb2004694adaab7bbd778a25df25c47b9d4155a55f8fbd79f2fe154cff"},
+    {8192, "aae792484c8efe4f19e2ca7d371d8c467ffb10748d8a5a1ae579948f718a2a63"},
+    {8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+    {16384, "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4"},
+    {31744, "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47"},
+    {102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"}};
+
+static std::vector<tin::BLAKE3::Implementation> supportedImplementations()
+{
+    std::vector<tin::BLAKE3::Implementation> impls;
+    for (auto impl : {tin::BLAKE3::PORTABLE, tin::BLAKE3::SSE2, tin::BLAKE3::AVX2})
+    {
+        if (tin::BLAKE3::isSupported(impl))
+        {
+            impls.push_back(impl);
+        }
+    }
+    return impls;
+}
+
+// Generic over the engine, the way callers switch between SHA256 and BLAKE3
+template <typename Hasher>
+static std::string hexOf(const std::string &data)
+{
+    Hasher hasher;
+    hasher.update(data);
+    return Hasher::toString(hasher.digest());
+}
+
+void test_knownAnswers()
+{
+    for (auto impl : supportedImplementations())
+    {
+        tin::BLAKE3::setImplementation(impl);
+        assert(tin::BLAKE3::implementation() == impl);
+
+        for (const auto &vector : VECTORS)
+        {
+            tin::BLAKE3 hasher;
+            hasher.update(vectorInput(vector.first));
+            assert(tin::BLAKE3::toString(hasher.digest()) == vector.second);
+        }
+
+        std::cout << "known answers ok: " << tin::BLAKE3::implementationName(impl)
+                  << " (" << tin::BLAKE3::lanes() << " lanes)" << std::endl;
+    }
+}
+
+void test_keyed()
+{
+    std::array<uint8_t, tin::BLAKE3::KEY_LENGTH> key;
+    std::memcpy(key.data(), "whats the Elvish word for friend", key.size());
+
+    const std::pair<size_t, const char *> keyed[] = {
+        {0, "92b2b75604ed3c761f9d6f62392c8a9227ad0ea3f09573e783f1498a4ed60d26"},
+        {1, "6d7878dfff2f485635d39013278ae14f1454b8c0a3a2d34bc1ab38228a80c95b"},
+        {1025, "357dc55de0c7e382c900fd6e320acc04146be01db6a8ce7210b7189bd664ea69"},
+        {8193, "954a2a75420c8d6547e3ba5b98d963e6fa6491addc8c023189cc519821b4a1f5"}};
+
+    for (auto impl : supportedImplementations())
+    {
+        tin::BLAKE3::setImplementation(impl);
+        for (const auto &vector : keyed)
+        {
+            tin::BLAKE3 hasher(key);
+            hasher.update(vectorInput(vector.first));
+            assert(tin::BLAKE3::toString(hasher.digest()) == vector.second);
+        }
+    }
+}
+
+void test_chunkedUpdate()
+{
+    std::vector<uint8_t> message = vectorInput(31744);
+    const char *expected = VECTORS[18].second;
+
+    for (auto impl : supportedImplementations())
+    {
+        tin::BLAKE3::setImplementation(impl);
+        for (size_t chunk : {1, 63, 64, 65, 1000, 1024, 1025, 4096, 20000})
+        {
+            tin::BLAKE3 hasher;
+            for (size_t offset = 0; offset < message.size(); offset += chunk)
+            {
+                hasher.update(message.data() + offset, std::min(chunk, message.size() - offset));
+            }
+            assert(tin::BLAKE3::toString(hasher.digest()) == expected);
+        }
+    }
+}
+
+void test_hashParallel()
+{
+    tin::ThreadPool pool(4);
+
+    for (auto impl : supportedImplementations())
+    {
+        tin::BLAKE3::setImplementation(impl);
+        for (const auto &vector : VECTORS)
+        {
+            std::vector<uint8_t> input = vectorInput(vector.first);
+            assert(tin::BLAKE3::toString(tin::BLAKE3::hashParallel(input, pool)) == vector.second);
+        }
+
+        // Many levels with odd nodes carried up
+        std::vector<uint8_t> large = vectorInput(3 * 1000 * 1000 + 17);
+        tin::BLAKE3 sequential;
+        sequential.update(large);
+        assert(tin::BLAKE3::hashParallel(large, pool) == sequential.digest());
+    }
+}
+
+void test_templateEngines()
+{
+    assert(hexOf<tin::SHA256>("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    assert(hexOf<tin::BLAKE3>("abc") == "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85");
+}
+
+int main()
+{
+    auto best = tin::BLAKE3::implementation();
+    std::cout << "default implementation: " << tin::BLAKE3::implementationName(best) << std::endl;
+
+    test_knownAnswers();
+    test_keyed();
+    test_chunkedUpdate();
+    test_hashParallel();
+    test_templateEngines();
+
+    tin::BLAKE3::setImplementation(best);
+    std::cout << "All BLAKE3 tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include "ChunkStore.hpp"
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <stdexcept>
+#include <cstring>
+
+namespace tin
+{
+    constexpr size_t FastCDC::MIN_SIZE;
+    constexpr size_t FastCDC::AVG_SIZE;
+    constexpr size_t FastCDC::MAX_SIZE;
+    constexpr uint64_t FastCDC::MASK_S;
+    constexpr uint64_t FastCDC::MASK_L;
+    constexpr size_t ChunkStore::SEGMENT_SIZE;
+
+    const std::array<uint64_t, 256> &FastCDC::gear()
+    {
+        // splitmix64 from a fixed seed: the table, and therefore every cut
+        // point, must be identical on every node for chunks to deduplicate.
+        static const std::array<uint64_t, 256> table = []()
+        {
+            std::array<uint64_t, 256> t;
+            uint64_t seed = 0x74696e4344433031ULL;
+            for (auto &entry : t)
+            {
+                uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                entry = z ^ (z >> 31);
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    size_t FastCDC::cut(const uint8_t *data, size_t size)
+    {
+        if (size <= MIN_SIZE)
+            return size;
+
+        const std::array<uint64_t, 256> &table = gear();
+        size_t end = std::min(size, MAX_SIZE);
+        size_t normal = std::min(end, AVG_SIZE);
+        uint64_t fp = 0;
+        size_t i = MIN_SIZE;
+
+        // Harder mask before the average size, easier one after it
+        for (; i < normal; i++)
+        {
+            fp = (fp << 1) + table[data[i]];
+            if (!(fp & MASK_S))
+                return i;
+        }
+        for (; i < end; i++)
+        {
+            fp = (fp << 1) + table[data[i]];
+            if (!(fp & MASK_L))
+                return i;
+        }
+        return end;
+    }
+
+    size_t ChunkStore::ChunkIdHash::operator()(const ChunkId &id) const
+    {
+        // Ids are uniformly distributed already
+        size_t h;
+        std::memcpy(&h, id.data(), sizeof(h));
+        return h;
+    }
+
+    ChunkStore::ChunkStore(const std::string &directory, ThreadPool &pool)
+        : directory(directory), pool(pool)
+    {
+        namespace fs = std::filesystem;
+        fs::create_directories(fs::path(directory) / "chunks");
+        fs::create_directories(fs::path(directory) / "recipes");
+
+        for (const auto &entry : fs::recursive_directory_iterator(fs::path(directory) / "chunks"))
+        {
+            std::string name = entry.path().filename().string();
+            if (!entry.is_regular_file() || name.size() != SHA256::DIGEST_LENGTH * 2)
+                continue;
+
+            ChunkId id;
+            for (size_t i = 0; i < id.size(); i++)
+            {
+                id[i] = std::stoi(name.substr(i * 2, 2), nullptr, 16);
+            }
+            known.insert(id);
+        }
+    }
+
+    std::vector<ChunkStore::ChunkId> ChunkStore::put(std::istream &in)
+    {
+        std::vector<ChunkId> recipe;
+        std::vector<uint8_t> buffer(SEGMENT_SIZE);
+        size_t filled = 0;
+
+        while (true)
+        {
+            in.read(reinterpret_cast<char *>(buffer.data() + filled), buffer.size() - filled);
+            filled += in.gcount();
+            bool last = !in;
+
+            size_t used = putSegment(buffer.data(), filled, last, recipe);
+            if (last)
+                break;
+
+            std::memmove(buffer.data(), buffer.data() + used, filled - used);
+            filled -= used;
+        }
+
+        if (in.bad())
+        {
+            throw std::runtime_error("Unable to read chunk store input");
+        }
+        return recipe;
+    }
+
+    std::vector<ChunkStore::ChunkId> ChunkStore::put(ByteView data)
+    {
+        std::vector<ChunkId> recipe;
+        putSegment(data.data, data.size, true, recipe);
+        return recipe;
+    }
+
+    std::vector<ChunkStore::ChunkId> ChunkStore::putFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Unable to open " + path);
+        }
+        return put(file);
+    }
+
+    size_t ChunkStore::putSegment(const uint8_t *data, size_t size, bool last, std::vector<ChunkId> &recipe)
+    {
+        // Cutting is sequential (each cut depends on the previous one);
+        // hashing the chunks is not.
+        std::vector<std::pair<size_t, size_t>> chunks;
+        size_t offset = 0;
+        while (offset < size && (last || size - offset >= FastCDC::MAX_SIZE))
+        {
+            size_t length = FastCDC::cut(data + offset, size - offset);
+            chunks.emplace_back(offset, length);
+            offset += length;
+        }
+
+        std::vector<ChunkId> ids(chunks.size());
+        pool.parallelFor(0, chunks.size(), 16, [&](size_t begin, size_t end)
+                         {
+            for (size_t i = begin; i < end; i++)
+            {
+                SHA256 sha;
+                ids[i] = sha.update(data + chunks[i].first, chunks[i].second).digest();
+            } });
+
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            totals.chunks++;
+            totals.bytesIn += chunks[i].second;
+            // Known only once the file is in place, so a failed write is
+            // retried by the next put of the same data
+            if (!known.count(ids[i]))
+            {
+                writeChunk(ids[i], data + chunks[i].first, chunks[i].second);
+                known.insert(ids[i]);
+                totals.newChunks++;
+                totals.bytesStored += chunks[i].second;
+            }
+            recipe.push_back(ids[i]);
+        }
+
+        return offset;
+    }
+
+    bool ChunkStore::contains(const ChunkId &id) const
+    {
+        return known.count(id) > 0;
+    }
+
+    std::string ChunkStore::chunkPath(const ChunkId &id) const
+    {
+        std::string hex = SHA256::toString(id);
+        return directory + "/chunks/" + hex.substr(0, 2) + "/" + hex;
+    }
+
+    void ChunkStore::writeChunk(const ChunkId &id, const uint8_t *data, size_t size)
+    {
+        std::string path = chunkPath(id);
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+
+        // Write then rename, so a crash never leaves a truncated chunk under
+        // its final name
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(data), size);
+            file.close();
+            if (!file)
+            {
+                throw std::runtime_error("Unable to write chunk " + temp);
+            }
+        }
+        std::filesystem::rename(temp, path);
+    }
+
+    void ChunkStore::get(const std::vector<ChunkId> &recipe, std::ostream &out) const
+    {
+        std::vector<char> buffer(FastCDC::MAX_SIZE);
+        for (const ChunkId &id : recipe)
+        {
+            std::ifstream file(chunkPath(id), std::ios::binary);
+            if (!file.is_open())
+            {
+                throw std::runtime_error("Missing chunk " + SHA256::toString(id));
+            }
+
+            while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+            {
+                out.write(buffer.data(), file.gcount());
+            }
+        }
+    }
+
+    std::vector<uint8_t> ChunkStore::get(const std::vector<ChunkId> &recipe) const
+    {
+        std::ostringstream out;
+        get(recipe, out);
+        std::string bytes = out.str();
+        return std::vector<uint8_t>(bytes.begin(), bytes.end());
+    }
+
+    void ChunkStore::saveRecipe(const std::string &name, const std::vector<ChunkId> &recipe) const
+    {
+        std::ofstream file(directory + "/recipes/" + name, std::ios::binary | std::ios::trunc);
+        for (const ChunkId &id : recipe)
+        {
+            file.write(reinterpret_cast<const char *>(id.data()), id.size());
+        }
+        if (!file)
+        {
+            throw std::runtime_error("Unable to write recipe " + name);
+        }
+    }
+
+    std::vector<ChunkStore::ChunkId> ChunkStore::loadRecipe(const std::string &name) const
+    {
+        std::ifstream file(directory + "/recipes/" + name, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Unknown recipe " + name);
+        }
+
+        std::vector<ChunkId> recipe;
+        ChunkId id;
+        while (file.read(reinterpret_cast<char *>(id.data()), id.size()))
+        {
+            recipe.push_back(id);
+        }
+        return recipe;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef CHUNKSTORE_HPP
+#define CHUNKSTORE_HPP
+
+#include "../SHA256/SHA256.hpp"
+#include "../../concurrency/ThreadPool/ThreadPool.hpp"
+#include <string>
+#include <vector>
+#include <array>
+#include <istream>
+#include <ostream>
+#include <unordered_set>
+#include <cstdint>
+
+namespace tin
+{
+    /**
+     * FastCDC content-defined chunker (Xia et al., USENIX ATC '16) with
+     * normalized chunking. Cut points depend only on nearby content, so an
+     * insertion early in a stream leaves the chunks after it unchanged.
+     */
+    class FastCDC
+    {
+    public:
+        static constexpr size_t MIN_SIZE = 2 << 10;
+        static constexpr size_t AVG_SIZE = 8 << 10;
+        static constexpr size_t MAX_SIZE = 64 << 10;
+
+        // Length of the chunk starting at `data`; `size` bytes are available
+        static size_t cut(const uint8_t *data, size_t size);
+
+    private:
+        static constexpr uint64_t MASK_S = 0x0003590703530000ULL;
+        static constexpr uint64_t MASK_L = 0x0000d90003530000ULL;
+
+        static const std::array<uint64_t, 256> &gear();
+    };
+
+    /**
+     * Content-addressed store: streams are split with FastCDC, chunks are
+     * hashed in parallel and each distinct chunk is written once under
+     * <directory>/chunks/<xx>/<sha256 hex>. A stream is recorded as its
+     * recipe, the ordered list of chunk ids, which can be saved by name.
+     */
+    class ChunkStore
+    {
+    public:
+        typedef std::array<uint8_t, SHA256::DIGEST_LENGTH> ChunkId;
+
+        struct Stats
+        {
+            uint64_t bytesIn = 0;
+            uint64_t bytesStored = 0;
+            uint64_t chunks = 0;
+            uint64_t newChunks = 0;
+        };
+
+        explicit ChunkStore(const std::string &directory, ThreadPool &pool = ThreadPool::shared());
+
+        std::vector<ChunkId> put(std::istream &in);
+        std::vector<ChunkId> put(ByteView data);
+        std::vector<ChunkId> putFile(const std::string &path);
+        void get(const std::vector<ChunkId> &recipe, std::ostream &out) const;
+        std::vector<uint8_t> get(const std::vector<ChunkId> &recipe) const;
+        bool contains(const ChunkId &id) const;
+
+        void saveRecipe(const std::string &name, const std::vector<ChunkId> &recipe) const;
+        std::vector<ChunkId> loadRecipe(const std::string &name) const;
+
+        const Stats &stats() const { return totals; }
+
+    private:
+        struct ChunkIdHash
+        {
+            size_t operator()(const ChunkId &id) const;
+        };
+
+        static constexpr size_t SEGMENT_SIZE = 16 << 20;
+
+        std::string directory;
+        ThreadPool &pool;
+        std::unordered_set<ChunkId, ChunkIdHash> known;
+        Stats totals;
+
+        // Chunks, hashes and stores data[0, size); returns the bytes consumed.
+        // Without `last`, a tail shorter than MAX_SIZE is left for the next call.
+        size_t putSegment(const uint8_t *data, size_t size, bool last, std::vector<ChunkId> &recipe);
+        std::string chunkPath(const ChunkId &id) const;
+        void writeChunk(const ChunkId &id, const uint8_t *data, size_t size);
+    };
+}
+
+#include "ChunkStore.cpp"
+
+#endif // CHUNKSTORE_HPP
@@ -0,0 +1,113 @@
+#include "../ChunkStore.hpp"
+#include <iostream>
+#include <sstream>
+#include <cassert>
+#include <filesystem>
+
+static std::vector<uint8_t> pseudoRandomBytes(size_t length, uint32_t seed)
+{
+    std::vector<uint8_t> bytes(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        bytes[i] = seed >> 16;
+    }
+    return bytes;
+}
+
+void test_chunkBounds()
+{
+    std::vector<uint8_t> data = pseudoRandomBytes(1 << 20, 1);
+    size_t offset = 0, chunks = 0;
+    while (offset < data.size())
+    {
+        size_t length = tin::FastCDC::cut(data.data() + offset, data.size() - offset);
+        assert(length <= tin::FastCDC::MAX_SIZE);
+        assert(length >= tin::FastCDC::MIN_SIZE || offset + length == data.size());
+        offset += length;
+        chunks++;
+    }
+    // Normalized chunking keeps the mean close to AVG_SIZE
+    size_t mean = data.size() / chunks;
+    assert(mean > tin::FastCDC::AVG_SIZE / 2 && mean < tin::FastCDC::AVG_SIZE * 2);
+}
+
+void test_deduplication()
+{
+    const std::string directory = "chunkstore_test";
+    std::filesystem::remove_all(directory);
+
+    std::vector<uint8_t> snapshot = pseudoRandomBytes(3 << 20, 2);
+    std::vector<uint8_t> edited = snapshot;
+    std::vector<uint8_t> inserted = pseudoRandomBytes(100, 3);
+    edited.insert(edited.begin() + (1 << 20), inserted.begin(), inserted.end());
+
+    {
+        tin::ChunkStore store(directory);
+        auto first = store.put(snapshot);
+        uint64_t storedAfterFirst = store.stats().bytesStored;
+        assert(storedAfterFirst == snapshot.size());
+
+        // Stream input with a carried tail must chunk exactly like one buffer
+        std::istringstream stream(std::string(edited.begin(), edited.end()));
+        auto second = store.put(stream);
+
+        // Only the chunks around the insertion are new
+        assert(store.stats().bytesStored - storedAfterFirst < 4 * tin::FastCDC::MAX_SIZE);
+        assert(store.get(first) == snapshot);
+        assert(store.get(second) == edited);
+
+        store.saveRecipe("edited", second);
+    }
+
+    // Reopening picks up the stored chunks and recipes
+    tin::ChunkStore reopened(directory);
+    auto recipe = reopened.loadRecipe("edited");
+    assert(reopened.get(recipe) == edited);
+    reopened.put(snapshot);
+    assert(reopened.stats().newChunks == 0);
+
+    std::filesystem::remove_all(directory);
+}
+
+void test_failedWriteIsRetried()
+{
+    const std::string directory = "chunkstore_retry_test";
+    std::filesystem::remove_all(directory);
+
+    // One chunk, whose temp path is blocked by a directory
+    std::vector<uint8_t> data = pseudoRandomBytes(1000, 4);
+    tin::SHA256 sha;
+    std::string hex = tin::SHA256::toString(sha.update(data.data(), data.size()).digest());
+    std::string temp = directory + "/chunks/" + hex.substr(0, 2) + "/" + hex + ".tmp";
+
+    tin::ChunkStore store(directory);
+    std::filesystem::create_directories(temp + "/blocker");
+    bool threw = false;
+    try
+    {
+        store.put(data);
+    }
+    catch (const std::exception &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    std::filesystem::remove_all(temp);
+    auto recipe = store.put(data);
+    assert(store.stats().newChunks == 1);
+    assert(store.get(recipe) == data);
+
+    std::filesystem::remove_all(directory);
+}
+
+int main()
+{
+    test_chunkBounds();
+    test_deduplication();
+    test_failedWriteIsRetried();
+
+    std::cout << "All ChunkStore tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "Digest.hpp"
+#include <stdexcept>
+
+namespace tin
+{
+    constexpr size_t Digest::LENGTH;
+    constexpr size_t Digest::HEX_LENGTH;
+
+    Digest Digest::fromHex(const std::string &hex)
+    {
+        Digest digest;
+        if (!fromHex(hex.data(), hex.size(), digest))
+        {
+            throw std::invalid_argument("Invalid digest hex: " + hex);
+        }
+        return digest;
+    }
+
+    bool Digest::fromHex(const char *hex, size_t length, Digest &out)
+    {
+        return length == HEX_LENGTH && Hex::decode(hex, LENGTH, out.bytes.data());
+    }
+
+    bool Digest::isZero() const
+    {
+        uint8_t any = 0;
+        for (uint8_t byte : bytes)
+        {
+            any |= byte;
+        }
+        return any == 0;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef DIGEST_HPP
+#define DIGEST_HPP
+
+#include "Hex.hpp"
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+namespace tin
+{
+    /**
+     * A 32-byte hash held by value. Converts to and from the
+     * std::array<uint8_t, 32> that SHA256/BLAKE3 digest() return, compares
+     * with memcmp and hashes by reading its first 8 bytes, so it can key
+     * std::map and std::unordered_map without allocating a hex string.
+     */
+    class Digest
+    {
+    public:
+        static constexpr size_t LENGTH = 32;
+        static constexpr size_t HEX_LENGTH = LENGTH * 2;
+
+        std::array<uint8_t, LENGTH> bytes;
+
+        Digest() : bytes() {}
+        Digest(const std::array<uint8_t, LENGTH> &bytes) : bytes(bytes) {}
+        explicit Digest(const uint8_t *data) { std::memcpy(bytes.data(), data, LENGTH); }
+
+        // Throws std::invalid_argument unless hex is exactly 64 hex characters
+        static Digest fromHex(const std::string &hex);
+        static bool fromHex(const char *hex, size_t length, Digest &out);
+
+        void toHex(char *out) const { Hex::encode(bytes.data(), LENGTH, out); }
+        std::string toString() const { return Hex::encode(bytes.data(), LENGTH); }
+
+        bool isZero() const;
+
+        uint8_t *data() { return bytes.data(); }
+        const uint8_t *data() const { return bytes.data(); }
+        static constexpr size_t size() { return LENGTH; }
+        uint8_t &operator[](size_t i) { return bytes[i]; }
+        uint8_t operator[](size_t i) const { return bytes[i]; }
+        operator const std::array<uint8_t, LENGTH> &() const { return bytes; }
+
+        bool operator==(const Digest &other) const { return std::memcmp(bytes.data(), other.bytes.data(), LENGTH) == 0; }
+        bool operator!=(const Digest &other) const { return !(*this == other); }
+        bool operator<(const Digest &other) const { return std::memcmp(bytes.data(), other.bytes.data(), LENGTH) < 0; }
+
+        // Keys on the last 8 bytes: block hashes that meet a difficulty
+        // lead with zeros, but every digest's tail is uniformly distributed
+        struct Hash
+        {
+            size_t operator()(const Digest &digest) const
+            {
+                uint64_t word;
+                std::memcpy(&word, digest.bytes.data() + LENGTH - sizeof(word), sizeof(word));
+                return size_t(word);
+            }
+        };
+    };
+}
+
+namespace std
+{
+    template <>
+    struct hash<tin::Digest> : tin::Digest::Hash
+    {
+    };
+}
+
+#include "Digest.cpp"
+
+#endif // DIGEST_HPP
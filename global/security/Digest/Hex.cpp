@@ -0,0 +1,72 @@
+#include "Hex.hpp"
+
+namespace tin
+{
+    namespace hex_tables
+    {
+        struct Tables
+        {
+            char pairs[512];
+            uint8_t nibbles[256];
+
+            constexpr Tables() : pairs(), nibbles()
+            {
+                const char digits[] = "0123456789abcdef";
+                for (int i = 0; i < 256; i++)
+                {
+                    pairs[i * 2] = digits[i >> 4];
+                    pairs[i * 2 + 1] = digits[i & 15];
+                    nibbles[i] = 0xff;
+                }
+                for (int i = 0; i < 10; i++)
+                {
+                    nibbles['0' + i] = i;
+                }
+                for (int i = 0; i < 6; i++)
+                {
+                    nibbles['a' + i] = 10 + i;
+                    nibbles['A' + i] = 10 + i;
+                }
+            }
+        };
+
+        static constexpr Tables TABLES;
+    }
+
+    void Hex::encode(const uint8_t *data, size_t size, char *out)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            const char *pair = hex_tables::TABLES.pairs + data[i] * 2;
+            out[i * 2] = pair[0];
+            out[i * 2 + 1] = pair[1];
+        }
+    }
+
+    std::string Hex::encode(const uint8_t *data, size_t size)
+    {
+        std::string hex(size * 2, '\0');
+        encode(data, size, &hex[0]);
+        return hex;
+    }
+
+    bool Hex::decode(const char *hex, size_t size, uint8_t *out)
+    {
+        // Invalid characters map to 0xff; OR-ing every nibble lets one
+        // branch at the end catch them all
+        uint8_t invalid = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            uint8_t high = hex_tables::TABLES.nibbles[uint8_t(hex[i * 2])];
+            uint8_t low = hex_tables::TABLES.nibbles[uint8_t(hex[i * 2 + 1])];
+            invalid |= high | low;
+            out[i] = uint8_t(high << 4) | low;
+        }
+        return (invalid & 0xf0) == 0;
+    }
+
+    bool Hex::decode(const std::string &hex, uint8_t *out, size_t size)
+    {
+        return hex.size() == size * 2 && decode(hex.data(), size, out);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef HEX_HPP
+#define HEX_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace tin
+{
+    /**
+     * Lowercase hex encoding through lookup tables: one 2-character entry per
+     * byte for encode, one nibble per character for decode. Both work on
+     * caller-provided buffers so hot paths need no allocation.
+     */
+    class Hex
+    {
+    public:
+        // Writes 2 * size characters to out (no terminator)
+        static void encode(const uint8_t *data, size_t size, char *out);
+        static std::string encode(const uint8_t *data, size_t size);
+
+        // Reads 2 * size characters into size bytes; accepts either case.
+        // Returns false on any non-hex character, leaving out unspecified.
+        static bool decode(const char *hex, size_t size, uint8_t *out);
+        static bool decode(const std::string &hex, uint8_t *out, size_t size);
+    };
+}
+
+#include "Hex.cpp"
+
+#endif // HEX_HPP
@@ -0,0 +1,117 @@
+#include "../Digest.hpp"
+#include "../../SHA256/SHA256.hpp"
+#include <iostream>
+#include <cassert>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include <stdexcept>
+
+void test_hexRoundTrip()
+{
+    uint8_t bytes[256];
+    for (int i = 0; i < 256; i++)
+    {
+        bytes[i] = i;
+    }
+
+    std::string hex = tin::Hex::encode(bytes, sizeof(bytes));
+    assert(hex.size() == 512);
+    assert(hex.substr(0, 8) == "00010203");
+    assert(hex.substr(504) == "fcfdfeff");
+
+    uint8_t decoded[256];
+    assert(tin::Hex::decode(hex, decoded, sizeof(decoded)));
+    assert(std::memcmp(bytes, decoded, sizeof(bytes)) == 0);
+
+    uint8_t one;
+    assert(tin::Hex::decode("aB", 1, &one) && one == 0xab);
+    assert(!tin::Hex::decode("0g", 1, &one));
+    assert(!tin::Hex::decode("g0", 1, &one));
+    assert(!tin::Hex::decode(std::string("abc"), &one, 1));
+}
+
+void test_digest()
+{
+    tin::SHA256 sha;
+    sha.update(std::string("abc"));
+    tin::Digest digest = sha.digest();
+
+    const std::string hex = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+    assert(digest.toString() == hex);
+    assert(tin::SHA256::toString(digest) == hex);
+    assert(tin::Digest::fromHex(hex) == digest);
+    assert(tin::Digest::fromHex("BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD") == digest);
+
+    char buffer[tin::Digest::HEX_LENGTH];
+    digest.toHex(buffer);
+    assert(std::string(buffer, sizeof(buffer)) == hex);
+
+    for (const std::string &bad : {std::string(""), hex.substr(1), hex + "0", "x" + hex.substr(1)})
+    {
+        bool threw = false;
+        try
+        {
+            tin::Digest::fromHex(bad);
+        }
+        catch (const std::invalid_argument &)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    assert(tin::Digest().isZero());
+    assert(!digest.isZero());
+}
+
+void test_mapKeys()
+{
+    std::map<tin::Digest, int> ordered;
+    std::unordered_map<tin::Digest, int> unordered;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        tin::SHA256 sha;
+        sha.update(std::to_string(i));
+        tin::Digest digest = sha.digest();
+        ordered[digest] = i;
+        unordered[digest] = i;
+    }
+
+    assert(ordered.size() == 1000 && unordered.size() == 1000);
+    for (int i = 0; i < 1000; i++)
+    {
+        tin::SHA256 sha;
+        sha.update(std::to_string(i));
+        tin::Digest digest = sha.digest();
+        assert(ordered.at(digest) == i && unordered.at(digest) == i);
+    }
+
+    tin::Digest low, high;
+    high[0] = 1;
+    assert(low < high && !(high < low) && low != high);
+
+    // Mined block hashes lead with zero bytes; they must still spread
+    std::unordered_set<size_t> hashes;
+    for (int i = 0; i < 1000; i++)
+    {
+        tin::SHA256 sha;
+        sha.update(std::to_string(i));
+        tin::Digest digest = sha.digest();
+        std::memset(digest.data(), 0, 12);
+        hashes.insert(std::hash<tin::Digest>()(digest));
+    }
+    assert(hashes.size() == 1000);
+}
+
+int main()
+{
+    test_hexRoundTrip();
+    test_digest();
+    test_mapKeys();
+
+    std::cout << "All Digest tests passed" << std::endl;
+    return 0;
+}
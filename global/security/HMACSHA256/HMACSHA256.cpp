@@ -0,0 +1,77 @@
+#include "HMACSHA256.hpp"
+#include <cstring>
+
+namespace tin
+{
+    constexpr size_t HMACSHA256::TAG_LENGTH;
+
+    HMACSHA256::HMACSHA256(ByteView key)
+    {
+        uint8_t block[SHA256::BLOCK_LENGTH] = {0};
+
+        if (key.size > SHA256::BLOCK_LENGTH)
+        {
+            SHA256 sha;
+            auto hashed = sha.update(key).digest();
+            std::memcpy(block, hashed.data(), hashed.size());
+        }
+        else if (key.size > 0)
+        {
+            std::memcpy(block, key.data, key.size);
+        }
+
+        uint8_t pad[SHA256::BLOCK_LENGTH];
+        for (size_t i = 0; i < SHA256::BLOCK_LENGTH; i++)
+        {
+            pad[i] = block[i] ^ 0x36;
+        }
+        inner = SHA256().update(pad, sizeof(pad)).checkpoint();
+
+        for (size_t i = 0; i < SHA256::BLOCK_LENGTH; i++)
+        {
+            pad[i] = block[i] ^ 0x5c;
+        }
+        outer = SHA256().update(pad, sizeof(pad)).checkpoint();
+    }
+
+    std::array<uint8_t, HMACSHA256::TAG_LENGTH> HMACSHA256::mac(ByteView message) const
+    {
+        SHA256 sha;
+        sha.restore(inner).update(message);
+        return finish(sha);
+    }
+
+    std::array<uint8_t, HMACSHA256::TAG_LENGTH> HMACSHA256::mac(ByteView header, ByteView message) const
+    {
+        SHA256 sha;
+        sha.restore(inner).update(header).update(message);
+        return finish(sha);
+    }
+
+    bool HMACSHA256::verify(ByteView message, const uint8_t *tag) const
+    {
+        return equal(mac(message).data(), tag);
+    }
+
+    bool HMACSHA256::verify(ByteView header, ByteView message, const uint8_t *tag) const
+    {
+        return equal(mac(header, message).data(), tag);
+    }
+
+    std::array<uint8_t, HMACSHA256::TAG_LENGTH> HMACSHA256::finish(SHA256 &sha) const
+    {
+        auto innerDigest = sha.digest();
+        return sha.restore(outer).update(innerDigest).digest();
+    }
+
+    // Constant time, so a forged tag cannot be found byte by byte
+    bool HMACSHA256::equal(const uint8_t *a, const uint8_t *b)
+    {
+        uint8_t diff = 0;
+        for (size_t i = 0; i < TAG_LENGTH; i++)
+        {
+            diff |= a[i] ^ b[i];
+        }
+        return diff == 0;
+    }
+}
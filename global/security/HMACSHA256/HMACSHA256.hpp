@@ -0,0 +1,39 @@
+#ifndef HMACSHA256_HPP
+#define HMACSHA256_HPP
+
+#include "../SHA256/SHA256.hpp"
+#include <array>
+#include <cstdint>
+
+namespace tin
+{
+    /**
+     * HMAC-SHA256 (RFC 2104) for a fixed key. The key is absorbed into the
+     * inner and outer pad states once, in the constructor; each mac() then
+     * restores those states and only hashes the message plus the 32-byte
+     * inner digest.
+     */
+    class HMACSHA256
+    {
+    public:
+        static constexpr size_t TAG_LENGTH = SHA256::DIGEST_LENGTH;
+
+        explicit HMACSHA256(ByteView key);
+
+        std::array<uint8_t, TAG_LENGTH> mac(ByteView message) const;
+        std::array<uint8_t, TAG_LENGTH> mac(ByteView header, ByteView message) const;
+        bool verify(ByteView message, const uint8_t *tag) const;
+        bool verify(ByteView header, ByteView message, const uint8_t *tag) const;
+
+    private:
+        SHA256::State inner;
+        SHA256::State outer;
+
+        std::array<uint8_t, TAG_LENGTH> finish(SHA256 &sha) const;
+        static bool equal(const uint8_t *a, const uint8_t *b);
+    };
+}
+
+#include "HMACSHA256.cpp"
+
+#endif // HMACSHA256_HPP
@@ -0,0 +1,56 @@
+#include "../HMACSHA256.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+
+static std::string hexMac(const tin::HMACSHA256 &hmac, const std::string &message)
+{
+    return tin::SHA256::toString(hmac.mac(message));
+}
+
+// RFC 4231 test cases 1, 2, 4 and 6
+void test_rfc4231()
+{
+    tin::HMACSHA256 case1(std::string(20, '\x0b'));
+    assert(hexMac(case1, "Hi There") == "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+
+    tin::HMACSHA256 case2(std::string("Jefe"));
+    assert(hexMac(case2, "what do ya want for nothing?") == "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+
+    std::vector<uint8_t> key4;
+    for (uint8_t i = 1; i <= 25; i++)
+    {
+        key4.push_back(i);
+    }
+    tin::HMACSHA256 case4(key4);
+    assert(hexMac(case4, std::string(50, '\xcd')) == "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b");
+
+    tin::HMACSHA256 case6(std::string(131, '\xaa'));
+    assert(hexMac(case6, "Test Using Larger Than Block-Size Key - Hash Key First") == "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+}
+
+void test_reuseAndVerify()
+{
+    tin::HMACSHA256 hmac(std::string("Jefe"));
+    std::string header = "what do ya ";
+    std::string body = "want for nothing?";
+
+    // The cached pad states must not be disturbed by earlier MACs
+    auto first = hmac.mac(header + body);
+    auto second = hmac.mac(header, body);
+    assert(first == second);
+
+    assert(hmac.verify(header + body, first.data()));
+    first[31] ^= 1;
+    assert(!hmac.verify(header, body, first.data()));
+}
+
+int main()
+{
+    test_rfc4231();
+    test_reuseAndVerify();
+
+    std::cout << "All HMAC-SHA256 tests passed" << std::endl;
+    return 0;
+}
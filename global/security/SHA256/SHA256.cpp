@@ -1,58 +1,105 @@
 #include "SHA256.hpp"
 #include <cstring>
-#include <sstream>
-#include <iomanip>
 #include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#ifdef TIN_SHA256_X86
+#include <cpuid.h>
+#endif
 
 namespace tin
 {
 
+    constexpr std::array<uint32_t, 8> SHA256::H0;
     constexpr std::array<uint32_t, 64> SHA256::K;
 
     SHA256::SHA256() : blockLen(0), bitLen(0)
     {
-        state[0] = 0x6a09e667;
-        state[1] = 0xbb67ae85;
-        state[2] = 0x3c6ef372;
-        state[3] = 0xa54ff53a;
-        state[4] = 0x510e527f;
-        state[5] = 0x9b05688c;
-        state[6] = 0x1f83d9ab;
-        state[7] = 0x5be0cd19;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            state[i] = H0[i];
+        }
     }
 
     SHA256 &SHA256::update(const uint8_t *input, size_t length)
     {
-        for (size_t i = 0; i < length; i++)
+        if (length == 0)
+            return *this;
+
+        if (blockLen > 0)
         {
-            data[blockLen++] = input[i];
-            if (blockLen == 64)
-            {
-                transform();
+            size_t take = std::min<size_t>(64 - blockLen, length);
+            memcpy(data + blockLen, input, take);
+            blockLen += take;
+            input += take;
+            length -= take;
 
-                bitLen += 512;
-                blockLen = 0;
-            }
+            if (blockLen < 64)
+                return *this;
+
+            transform();
+            bitLen += 512;
+            blockLen = 0;
+        }
+
+        // Whole blocks are compressed straight from the caller's buffer
+        size_t blocks = length / 64;
+        if (blocks > 0)
+        {
+            compress(state, input, blocks);
+            bitLen += 512 * uint64_t(blocks);
+            input += blocks * 64;
+            length -= blocks * 64;
+        }
+
+        if (length > 0)
+        {
+            memcpy(data, input, length);
+            blockLen = length;
         }
         return *this;
     }
 
+    SHA256 &SHA256::update(ByteView data)
+    {
+        return update(data.data, data.size);
+    }
+
     SHA256 &SHA256::update(const std::string &data)
     {
-        update(reinterpret_cast<const uint8_t *>(data.c_str()), data.size());
-        return *this;
+        return update(reinterpret_cast<const uint8_t *>(data.data()), data.size());
     }
 
-    SHA256 &SHA256::update(std::vector<uint8_t> &data)
+    SHA256 &SHA256::update(const std::vector<uint8_t> &data)
     {
         return update(data.data(), data.size());
     }
 
-    SHA256 &SHA256::update(std::array<uint8_t, tin::SHA256::DIGEST_LENGTH> &data)
+    SHA256 &SHA256::update(const std::array<uint8_t, tin::SHA256::DIGEST_LENGTH> &data)
     {
         return update(data.data(), data.size());
     }
-    
+
+    SHA256::State SHA256::checkpoint() const
+    {
+        State saved;
+        memcpy(saved.h, state, sizeof(state));
+        memcpy(saved.data, data, blockLen);
+        saved.blockLen = blockLen;
+        saved.bitLen = bitLen;
+        return saved;
+    }
+
+    SHA256 &SHA256::restore(const State &saved)
+    {
+        memcpy(state, saved.h, sizeof(state));
+        memcpy(data, saved.data, saved.blockLen);
+        blockLen = saved.blockLen;
+        bitLen = saved.bitLen;
+        return *this;
+    }
+
     std::array<uint8_t, 32> SHA256::digest()
     {
         std::array<uint8_t, 32> hash;
@@ -88,53 +135,245 @@ namespace tin
         return SHA256::rotate(x, 17) ^ SHA256::rotate(x, 19) ^ (x >> 10);
     }
 
-    void SHA256::transform()
+    void SHA256::rounds(uint32_t *state, const uint32_t *wk)
     {
-        uint32_t maj, xorA, ch, xorE, sum, newA, newE, m[64];
-        uint32_t state[8];
+        uint32_t maj, xorA, ch, xorE, sum, newA, newE;
+        uint32_t s[8];
 
-        for (uint8_t i = 0, j = 0; i < 16; i++, j += 4)
+        for (uint8_t i = 0; i < 8; i++)
         {
-            m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
+            s[i] = state[i];
         }
 
-        for (uint8_t k = 16; k < 64; k++)
+        for (uint8_t i = 0; i < 64; i++)
         {
-            m[k] = SHA256::sig1(m[k - 2]) + m[k - 7] + SHA256::sig0(m[k - 15]) + m[k - 16];
+            maj = SHA256::majority(s[0], s[1], s[2]);
+            xorA = SHA256::rotate(s[0], 2) ^ SHA256::rotate(s[0], 13) ^ SHA256::rotate(s[0], 22);
+
+            ch = choose(s[4], s[5], s[6]);
+
+            xorE = SHA256::rotate(s[4], 6) ^ SHA256::rotate(s[4], 11) ^ SHA256::rotate(s[4], 25);
+
+            sum = wk[i] + s[7] + ch + xorE;
+            newA = xorA + maj + sum;
+            newE = s[3] + sum;
+
+            s[7] = s[6];
+            s[6] = s[5];
+            s[5] = s[4];
+            s[4] = newE;
+            s[3] = s[2];
+            s[2] = s[1];
+            s[1] = s[0];
+            s[0] = newA;
         }
 
         for (uint8_t i = 0; i < 8; i++)
         {
-            state[i] = this->state[i];
+            state[i] += s[i];
         }
+    }
 
-        for (uint8_t i = 0; i < 64; i++)
+    void SHA256::transformScalar(uint32_t *state, const uint8_t *blocks, size_t count)
+    {
+        uint32_t m[64];
+
+        for (; count > 0; count--, blocks += 64)
         {
-            maj = SHA256::majority(state[0], state[1], state[2]);
-            xorA = SHA256::rotate(state[0], 2) ^ SHA256::rotate(state[0], 13) ^ SHA256::rotate(state[0], 22);
+            for (uint8_t i = 0, j = 0; i < 16; i++, j += 4)
+            {
+                m[i] = (blocks[j] << 24) | (blocks[j + 1] << 16) | (blocks[j + 2] << 8) | (blocks[j + 3]);
+            }
 
-            ch = choose(state[4], state[5], state[6]);
+            for (uint8_t k = 16; k < 64; k++)
+            {
+                m[k] = SHA256::sig1(m[k - 2]) + m[k - 7] + SHA256::sig0(m[k - 15]) + m[k - 16];
+            }
 
-            xorE = SHA256::rotate(state[4], 6) ^ SHA256::rotate(state[4], 11) ^ SHA256::rotate(state[4], 25);
+            for (uint8_t i = 0; i < 64; i++)
+            {
+                m[i] += K[i];
+            }
 
-            sum = m[i] + K[i] + state[7] + ch + xorE;
-            newA = xorA + maj + sum;
-            newE = state[3] + sum;
+            rounds(state, m);
+        }
+    }
+
+    SHA256::Implementation SHA256::detect()
+    {
+        if (isSupported(SHANI))
+            return SHANI;
+        if (isSupported(AVX2))
+            return AVX2;
+        if (isSupported(SSSE3))
+            return SSSE3;
+        return SCALAR;
+    }
+
+    bool SHA256::isSupported(Implementation impl)
+    {
+        if (impl == SCALAR)
+            return true;
+#ifdef TIN_SHA256_X86
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            return false;
+
+        bool ssse3 = ecx & bit_SSSE3;
+        bool sse41 = ecx & bit_SSE4_1;
+        bool osxsave = ecx & bit_OSXSAVE;
+        bool avx = ecx & bit_AVX;
+
+        if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+            ebx = 0;
+
+        switch (impl)
+        {
+        case SSSE3:
+            return ssse3;
+        case AVX2:
+        {
+            if (!(osxsave && avx && (ebx & bit_AVX2)))
+                return false;
+            // The OS must also save the YMM registers on context switch
+            uint32_t xcr0Lo, xcr0Hi;
+            __asm__ volatile("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+            return (xcr0Lo & 0x6) == 0x6;
+        }
+        case SHANI:
+            return ssse3 && sse41 && (ebx & bit_SHA);
+        default:
+            return false;
+        }
+#else
+        return false;
+#endif
+    }
 
-            state[7] = state[6];
-            state[6] = state[5];
-            state[5] = state[4];
-            state[4] = newE;
-            state[3] = state[2];
-            state[2] = state[1];
-            state[1] = state[0];
-            state[0] = newA;
+    SHA256::TransformFunc SHA256::kernel(Implementation impl)
+    {
+        switch (impl)
+        {
+#ifdef TIN_SHA256_X86
+        case SSSE3:
+            return &SHA256::transformSSSE3;
+        case AVX2:
+            return &SHA256::transformAVX2;
+        case SHANI:
+            return &SHA256::transformSHANI;
+#endif
+        default:
+            return &SHA256::transformScalar;
         }
+    }
 
-        for (uint8_t i = 0; i < 8; i++)
+    std::atomic<SHA256::TransformFunc> &SHA256::dispatch()
+    {
+        static std::atomic<TransformFunc> func(kernel(detect()));
+        return func;
+    }
+
+    void SHA256::compress(uint32_t *state, const uint8_t *blocks, size_t count)
+    {
+        dispatch().load(std::memory_order_relaxed)(state, blocks, count);
+    }
+
+    SHA256::Implementation SHA256::implementation()
+    {
+        TransformFunc current = dispatch().load(std::memory_order_relaxed);
+        for (Implementation impl : {SHANI, AVX2, SSSE3})
         {
-            this->state[i] += state[i];
+            if (current == kernel(impl))
+                return impl;
         }
+        return SCALAR;
+    }
+
+    void SHA256::setImplementation(Implementation impl)
+    {
+        if (!isSupported(impl))
+        {
+            throw std::invalid_argument(std::string("SHA256 implementation not supported: ") + implementationName(impl));
+        }
+        dispatch().store(kernel(impl), std::memory_order_relaxed);
+        laneWidth().store(lanesFor(impl), std::memory_order_relaxed);
+    }
+
+    const char *SHA256::implementationName(Implementation impl)
+    {
+        switch (impl)
+        {
+        case SSSE3:
+            return "ssse3";
+        case AVX2:
+            return "avx2";
+        case SHANI:
+            return "shani";
+        default:
+            return "scalar";
+        }
+    }
+
+    size_t SHA256::lanes()
+    {
+        return laneWidth().load(std::memory_order_relaxed);
+    }
+
+    // Set with the kernel, so hashMany() does not run CPUID on every call
+    std::atomic<size_t> &SHA256::laneWidth()
+    {
+        static std::atomic<size_t> width(lanesFor(implementation()));
+        return width;
+    }
+
+    size_t SHA256::lanesFor(Implementation impl)
+    {
+        // Eight AVX2 lanes out-run a SHA-NI loop on short messages, so the
+        // lanes stay in use when SHA-NI is the single-stream kernel.
+        switch (impl)
+        {
+        case SHANI:
+            return isSupported(AVX2) ? 8 : 1;
+        case AVX2:
+            return 8;
+        case SSSE3:
+            return 4;
+        default:
+            return 1;
+        }
+    }
+
+    void SHA256::hashMany(const ByteView *inputs, std::array<uint8_t, DIGEST_LENGTH> *outputs, size_t count)
+    {
+#ifdef TIN_SHA256_X86
+        switch (lanes())
+        {
+        case 8:
+            hashManyAVX2(inputs, outputs, count);
+            return;
+        case 4:
+            hashManySSE(inputs, outputs, count);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; i++)
+        {
+            SHA256 sha;
+            sha.update(inputs[i].data, inputs[i].size);
+            outputs[i] = sha.digest();
+        }
+    }
+
+    std::vector<std::array<uint8_t, SHA256::DIGEST_LENGTH>> SHA256::hashMany(const std::vector<ByteView> &inputs)
+    {
+        std::vector<std::array<uint8_t, DIGEST_LENGTH>> outputs(inputs.size());
+        hashMany(inputs.data(), outputs.data(), inputs.size());
+        return outputs;
+    }
+
+    void SHA256::transform()
+    {
+        compress(state, data, 1);
     }
 
     void SHA256::pad()
@@ -178,17 +417,135 @@ namespace tin
         }
     }
 
-    std::string SHA256::toString(const std::array<uint8_t, 32> &digest)
+    SHA256::PaddedSchedule::PaddedSchedule(size_t variableWords, uint64_t messageBits)
+        : variableWords(variableWords)
     {
-        std::stringstream s;
-        s << std::setfill('0') << std::hex;
+        uint32_t w[64] = {0};
+        w[variableWords] = 0x80000000;
+        w[14] = messageBits >> 32;
+        w[15] = messageBits;
 
-        for (uint8_t i = 0; i < 32; i++)
+        for (size_t i = 0; i < 16; i++)
         {
-            s << std::setw(2) << (unsigned int)digest[i];
+            wk[i] = i < variableWords ? 0 : w[i] + K[i];
         }
 
-        return s.str();
+        // Only terms that read a padding word are folded in here; terms that
+        // read message words or earlier scheduled words are added per hash.
+        auto isPadding = [variableWords](size_t i)
+        { return i >= variableWords && i < 16; };
+        for (size_t t = 16; t < 64; t++)
+        {
+            constant[t] = (isPadding(t - 2) ? SHA256::sig1(w[t - 2]) : 0) +
+                          (isPadding(t - 7) ? w[t - 7] : 0) +
+                          (isPadding(t - 15) ? SHA256::sig0(w[t - 15]) : 0) +
+                          (isPadding(t - 16) ? w[t - 16] : 0);
+        }
+    }
+
+    void SHA256::compressPadded(uint32_t *state, const uint32_t *words, const PaddedSchedule &schedule)
+    {
+        uint32_t m[64];
+        uint32_t wk[64];
+        size_t n = schedule.variableWords;
+
+        for (size_t i = 0; i < 16; i++)
+        {
+            m[i] = i < n ? words[i] : 0;
+            wk[i] = i < n ? words[i] + K[i] : schedule.wk[i];
+        }
+
+        for (size_t t = 16; t < 64; t++)
+        {
+            uint32_t w = schedule.constant[t];
+            if (t - 2 < n || t - 2 >= 16)
+                w += SHA256::sig1(m[t - 2]);
+            if (t - 7 < n || t - 7 >= 16)
+                w += m[t - 7];
+            if (t - 15 < n || t - 15 >= 16)
+                w += SHA256::sig0(m[t - 15]);
+            if (t - 16 < n || t - 16 >= 16)
+                w += m[t - 16];
+            m[t] = w;
+            wk[t] = w + K[t];
+        }
+
+        rounds(state, wk);
+    }
+
+    std::array<uint8_t, SHA256::DIGEST_LENGTH> sha256d_80(const uint8_t *input)
+    {
+        SHA256::State midstate;
+        memcpy(midstate.h, SHA256::H0.data(), sizeof(midstate.h));
+        SHA256::compress(midstate.h, input, 1);
+        midstate.blockLen = 0;
+        midstate.bitLen = 512;
+        return sha256d_80(midstate, input + 64);
+    }
+
+    std::array<uint8_t, SHA256::DIGEST_LENGTH> sha256d_80(const SHA256::State &midstate, const uint8_t *tail)
+    {
+        static const SHA256::PaddedSchedule tail80(4, 80 * 8);
+        static const SHA256::PaddedSchedule digest32(8, 32 * 8);
+
+        if (midstate.bitLen != 512 || midstate.blockLen != 0)
+        {
+            throw std::invalid_argument("sha256d_80 midstate must cover exactly the first 64 bytes");
+        }
+
+        uint32_t first[8];
+        uint32_t second[8];
+        memcpy(first, midstate.h, sizeof(first));
+        memcpy(second, SHA256::H0.data(), sizeof(second));
+
+        if (SHA256::implementation() == SHA256::SCALAR)
+        {
+            uint32_t words[4];
+            for (size_t i = 0; i < 4; i++)
+            {
+                words[i] = (tail[i * 4] << 24) | (tail[i * 4 + 1] << 16) | (tail[i * 4 + 2] << 8) | tail[i * 4 + 3];
+            }
+            SHA256::compressPadded(first, words, tail80);
+            SHA256::compressPadded(second, first, digest32);
+        }
+        else
+        {
+            // The hardware kernels take bytes, so the padding is laid out once
+            static const uint8_t pad80[48] = {0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x02, 0x80};
+            static const uint8_t pad32[32] = {0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x00};
+            uint8_t block[64];
+            memcpy(block, tail, 16);
+            memcpy(block + 16, pad80, sizeof(pad80));
+            SHA256::compress(first, block, 1);
+
+            for (size_t i = 0; i < 8; i++)
+            {
+                block[i * 4] = first[i] >> 24;
+                block[i * 4 + 1] = first[i] >> 16;
+                block[i * 4 + 2] = first[i] >> 8;
+                block[i * 4 + 3] = first[i];
+            }
+            memcpy(block + 32, pad32, sizeof(pad32));
+            SHA256::compress(second, block, 1);
+        }
+
+        std::array<uint8_t, SHA256::DIGEST_LENGTH> hash;
+        for (size_t i = 0; i < 8; i++)
+        {
+            hash[i * 4] = second[i] >> 24;
+            hash[i * 4 + 1] = second[i] >> 16;
+            hash[i * 4 + 2] = second[i] >> 8;
+            hash[i * 4 + 3] = second[i];
+        }
+        return hash;
+    }
+
+    std::string SHA256::toString(const std::array<uint8_t, 32> &digest)
+    {
+        return Hex::encode(digest.data(), digest.size());
     }
 
 }
\ No newline at end of file
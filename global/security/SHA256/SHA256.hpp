@@ -1,16 +1,42 @@
 #ifndef SHA256_HPP
 #define SHA256_HPP
 
+#include "../Digest/Hex.hpp"
 #include <string>
 #include <array>
+#include <vector>
+#include <atomic>
 #include <cstdint>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TIN_SHA256_X86 1
+#endif
+
 namespace tin
 {
+    /**
+     * Non-owning view of a byte range, the C++17 stand-in for span<const uint8_t>.
+     */
+    struct ByteView
+    {
+        const uint8_t *data;
+        size_t size;
+
+        ByteView(const uint8_t *data, size_t size) : data(data), size(size) {}
+        ByteView(const std::string &str) : data(reinterpret_cast<const uint8_t *>(str.data())), size(str.size()) {}
+        ByteView(const std::vector<uint8_t> &bytes) : data(bytes.data()), size(bytes.size()) {}
+        template <size_t N>
+        ByteView(const std::array<uint8_t, N> &bytes) : data(bytes.data()), size(N) {}
+    };
+
     class SHA256
     {
     public:
         static constexpr size_t DIGEST_LENGTH = 32;
+        static constexpr size_t BLOCK_LENGTH = 64;
+        static constexpr std::array<uint32_t, 8> H0 = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
         static constexpr std::array<uint32_t, 64> K = {
             0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
             0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
@@ -29,7 +55,33 @@ namespace tin
             0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
             0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
 
+        /**
+         * Compression kernels, in order of preference. The best one the CPU
+         * supports is picked once (CPUID) the first time a block is hashed.
+         */
+        enum Implementation
+        {
+            SCALAR,
+            SSSE3,
+            AVX2,
+            SHANI
+        };
+
+        /**
+         * Snapshot of a running hash. Taken after a shared prefix it lets the
+         * prefix be hashed once and extended many times.
+         */
+        struct State
+        {
+            uint32_t h[8];
+            uint8_t data[64];
+            uint32_t blockLen;
+            uint64_t bitLen;
+        };
+
     private:
+        typedef void (*TransformFunc)(uint32_t *state, const uint8_t *blocks, size_t count);
+
         uint8_t data[64];
         uint32_t blockLen;
         uint64_t bitLen;
@@ -39,6 +91,33 @@ namespace tin
         static uint32_t majority(uint32_t a, uint32_t b, uint32_t c);
         static uint32_t sig0(uint32_t x);
         static uint32_t sig1(uint32_t x);
+        static void rounds(uint32_t *state, const uint32_t *wk);
+        static void transformScalar(uint32_t *state, const uint8_t *blocks, size_t count);
+#ifdef TIN_SHA256_X86
+        static void transformSSSE3(uint32_t *state, const uint8_t *blocks, size_t count);
+        static void transformAVX2(uint32_t *state, const uint8_t *blocks, size_t count);
+        static void transformSHANI(uint32_t *state, const uint8_t *blocks, size_t count);
+        static void hashManySSE(const ByteView *inputs, std::array<uint8_t, DIGEST_LENGTH> *outputs, size_t count);
+        static void hashManyAVX2(const ByteView *inputs, std::array<uint8_t, DIGEST_LENGTH> *outputs, size_t count);
+#endif
+        // Constants for a final block that holds `variableWords` message words
+        // followed by fixed padding: K + W for the padding words, and the part
+        // of each scheduled word that depends only on the padding.
+        struct PaddedSchedule
+        {
+            size_t variableWords;
+            uint32_t wk[16];
+            uint32_t constant[64];
+
+            PaddedSchedule(size_t variableWords, uint64_t messageBits);
+        };
+        static void compressPadded(uint32_t *state, const uint32_t *words, const PaddedSchedule &schedule);
+        static Implementation detect();
+        static TransformFunc kernel(Implementation impl);
+        static std::atomic<TransformFunc> &dispatch();
+        static size_t lanesFor(Implementation impl);
+        static std::atomic<size_t> &laneWidth();
+        static void compress(uint32_t *state, const uint8_t *blocks, size_t count);
         void transform();
         void pad();
         void revert(std::array<uint8_t, DIGEST_LENGTH> &hash);
@@ -46,15 +125,40 @@ namespace tin
     public:
         SHA256();
         SHA256 &update(const uint8_t *input, size_t length);
+        SHA256 &update(ByteView data);
         SHA256 &update(const std::string &data);
-        SHA256 &update(std::vector<uint8_t> &data);
-        SHA256 &update(std::array<uint8_t, tin::SHA256::DIGEST_LENGTH> &data);
+        SHA256 &update(const std::vector<uint8_t> &data);
+        SHA256 &update(const std::array<uint8_t, tin::SHA256::DIGEST_LENGTH> &data);
         std::array<uint8_t, DIGEST_LENGTH> digest();
+        State checkpoint() const;
+        SHA256 &restore(const State &saved);
         static std::string toString(const std::array<uint8_t, DIGEST_LENGTH> &digest);
+
+        static void hashMany(const ByteView *inputs, std::array<uint8_t, DIGEST_LENGTH> *outputs, size_t count);
+        static std::vector<std::array<uint8_t, DIGEST_LENGTH>> hashMany(const std::vector<ByteView> &inputs);
+        static size_t lanes();
+
+        static bool isSupported(Implementation impl);
+        static Implementation implementation();
+        static void setImplementation(Implementation impl);
+        static const char *implementationName(Implementation impl);
+
+        friend std::array<uint8_t, DIGEST_LENGTH> sha256d_80(const uint8_t *input);
+        friend std::array<uint8_t, DIGEST_LENGTH> sha256d_80(const State &midstate, const uint8_t *tail);
     };
 
+    /**
+     * SHA256(SHA256(x)) for an 80-byte block header, without heap allocation.
+     * The midstate overload takes the state after the first 64 bytes
+     * (checkpoint() of a hasher fed exactly one block) and the last 16 bytes,
+     * so a miner only re-hashes the block that holds the nonce.
+     */
+    std::array<uint8_t, SHA256::DIGEST_LENGTH> sha256d_80(const uint8_t *input);
+    std::array<uint8_t, SHA256::DIGEST_LENGTH> sha256d_80(const SHA256::State &midstate, const uint8_t *tail);
+
 }
 
 #include "SHA256.cpp"
+#include "SHA256x86.cpp"
 
 #endif // SHA256_HPP
@@ -0,0 +1,181 @@
+#include "SHA256File.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace tin
+{
+    constexpr size_t SHA256File::WINDOW_SIZE;
+
+    std::array<uint8_t, SHA256::DIGEST_LENGTH> SHA256File::hash(const std::string &path, Mode mode)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Unable to open " + path + ": " + std::strerror(errno));
+        }
+
+        try
+        {
+            auto digest = hash(fd, mode);
+            close(fd);
+            return digest;
+        }
+        catch (...)
+        {
+            close(fd);
+            throw;
+        }
+    }
+
+    std::array<uint8_t, SHA256::DIGEST_LENGTH> SHA256File::hash(int fd, Mode mode)
+    {
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            throw std::runtime_error(std::string("Unable to stat file: ") + std::strerror(errno));
+        }
+
+        SHA256 sha;
+        bool mappable = S_ISREG(st.st_mode) && st.st_size > 0;
+
+        if (mode == MMAP && !mappable)
+        {
+            throw std::invalid_argument("Only non-empty regular files can be memory-mapped");
+        }
+
+        if (mode == BUFFERED || !mappable || !hashMapped(fd, st.st_size, sha))
+        {
+            if (mode == MMAP)
+            {
+                throw std::runtime_error(std::string("Unable to map file: ") + std::strerror(errno));
+            }
+            hashBuffered(fd, sha);
+        }
+
+        return sha.digest();
+    }
+
+    bool SHA256File::hashMapped(int fd, size_t size, SHA256 &sha)
+    {
+        void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            return false;
+        }
+
+        const uint8_t *bytes = static_cast<const uint8_t *>(map);
+        madvise(map, size, MADV_SEQUENTIAL);
+
+        // WINDOW_SIZE is a multiple of the page size, so window starts stay
+        // page aligned for madvise.
+        for (size_t offset = 0; offset < size; offset += WINDOW_SIZE)
+        {
+            size_t length = std::min(WINDOW_SIZE, size - offset);
+            size_t next = offset + length;
+            if (next < size)
+            {
+                madvise(const_cast<uint8_t *>(bytes) + next, std::min(WINDOW_SIZE, size - next), MADV_WILLNEED);
+            }
+
+            sha.update(bytes + offset, length);
+            madvise(const_cast<uint8_t *>(bytes) + offset, length, MADV_DONTNEED);
+        }
+
+        munmap(map, size);
+        return true;
+    }
+
+    void SHA256File::hashBuffered(int fd, SHA256 &sha)
+    {
+        struct Buffer
+        {
+            std::vector<uint8_t> bytes;
+            size_t length = 0;
+            bool full = false;
+        };
+
+        Buffer buffers[2];
+        buffers[0].bytes.resize(WINDOW_SIZE);
+        buffers[1].bytes.resize(WINDOW_SIZE);
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool done = false;
+        int readError = 0;
+
+        // Reader fills one buffer while this thread compresses the other
+        std::thread reader([&]()
+                           {
+            for (size_t turn = 0;; turn++)
+            {
+                Buffer &buf = buffers[turn & 1];
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return !buf.full; });
+                }
+
+                size_t filled = 0;
+                while (filled < WINDOW_SIZE)
+                {
+                    ssize_t n = read(fd, buf.bytes.data() + filled, WINDOW_SIZE - filled);
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n < 0)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        readError = errno;
+                        done = true;
+                        changed.notify_all();
+                        return;
+                    }
+                    if (n == 0)
+                        break;
+                    filled += n;
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                buf.length = filled;
+                buf.full = true;
+                if (filled < WINDOW_SIZE)
+                    done = true;
+                changed.notify_all();
+                if (done)
+                    return;
+            } });
+
+        for (size_t turn = 0;; turn++)
+        {
+            Buffer &buf = buffers[turn & 1];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]()
+                             { return buf.full || (done && readError != 0); });
+                if (readError != 0)
+                    break;
+            }
+
+            sha.update(buf.bytes.data(), buf.length);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            buf.full = false;
+            changed.notify_all();
+            if (buf.length < WINDOW_SIZE)
+                break;
+        }
+
+        reader.join();
+        if (readError != 0)
+        {
+            throw std::runtime_error(std::string("Unable to read file: ") + std::strerror(readError));
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef SHA256_FILE_HPP
+#define SHA256_FILE_HPP
+
+#include "SHA256.hpp"
+#include <string>
+#include <array>
+#include <cstdint>
+
+namespace tin
+{
+    /**
+     * Hashes a file through tin::SHA256 with constant memory. Regular files
+     * are memory-mapped and walked in windows: the next window is prefetched
+     * while the current one is compressed, and finished windows are dropped.
+     * Anything that cannot be mapped (pipes, sockets, some special files) is
+     * read by a second thread into two alternating buffers instead.
+     */
+    class SHA256File
+    {
+    public:
+        enum Mode
+        {
+            AUTO,
+            MMAP,
+            BUFFERED
+        };
+
+        static constexpr size_t WINDOW_SIZE = 4 << 20;
+
+        static std::array<uint8_t, SHA256::DIGEST_LENGTH> hash(const std::string &path, Mode mode = AUTO);
+        static std::array<uint8_t, SHA256::DIGEST_LENGTH> hash(int fd, Mode mode = AUTO);
+
+    private:
+        static bool hashMapped(int fd, size_t size, SHA256 &sha);
+        static void hashBuffered(int fd, SHA256 &sha);
+    };
+}
+
+#include "SHA256File.cpp"
+
+#endif // SHA256_FILE_HPP
@@ -0,0 +1,364 @@
+#include "SHA256.hpp"
+
+#ifdef TIN_SHA256_X86
+
+#include <immintrin.h>
+#include <cstring>
+
+namespace tin
+{
+    namespace sha256_x86
+    {
+        // Message schedule for four words: W[t..t+3] from the previous sixteen
+        // (w0 = W[t-16..t-13] ... w3 = W[t-4..t-1]). sigma1 depends on W[t] and
+        // W[t+1] for the upper two lanes, so it is applied in two halves.
+        __attribute__((target("ssse3"), always_inline)) inline __m128i schedule(__m128i w0, __m128i w1, __m128i w2, __m128i w3)
+        {
+            __m128i w15 = _mm_alignr_epi8(w1, w0, 4);
+            __m128i w7 = _mm_alignr_epi8(w3, w2, 4);
+
+            __m128i s0 = _mm_xor_si128(
+                _mm_xor_si128(_mm_or_si128(_mm_srli_epi32(w15, 7), _mm_slli_epi32(w15, 25)),
+                              _mm_or_si128(_mm_srli_epi32(w15, 18), _mm_slli_epi32(w15, 14))),
+                _mm_srli_epi32(w15, 3));
+            __m128i sum = _mm_add_epi32(_mm_add_epi32(w0, w7), s0);
+
+            __m128i w2lo = _mm_shuffle_epi32(w3, _MM_SHUFFLE(3, 3, 3, 2));
+            __m128i s1 = _mm_xor_si128(
+                _mm_xor_si128(_mm_or_si128(_mm_srli_epi32(w2lo, 17), _mm_slli_epi32(w2lo, 15)),
+                              _mm_or_si128(_mm_srli_epi32(w2lo, 19), _mm_slli_epi32(w2lo, 13))),
+                _mm_srli_epi32(w2lo, 10));
+            sum = _mm_add_epi32(sum, _mm_and_si128(s1, _mm_set_epi32(0, 0, -1, -1)));
+
+            __m128i w2hi = _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 1, 0));
+            s1 = _mm_xor_si128(
+                _mm_xor_si128(_mm_or_si128(_mm_srli_epi32(w2hi, 17), _mm_slli_epi32(w2hi, 15)),
+                              _mm_or_si128(_mm_srli_epi32(w2hi, 19), _mm_slli_epi32(w2hi, 13))),
+                _mm_srli_epi32(w2hi, 10));
+            return _mm_add_epi32(sum, _mm_and_si128(s1, _mm_set_epi32(-1, -1, 0, 0)));
+        }
+
+        // Same as schedule(), two blocks at once: one per 128-bit lane.
+        __attribute__((target("avx2"), always_inline)) inline __m256i schedule(__m256i w0, __m256i w1, __m256i w2, __m256i w3)
+        {
+            __m256i w15 = _mm256_alignr_epi8(w1, w0, 4);
+            __m256i w7 = _mm256_alignr_epi8(w3, w2, 4);
+
+            __m256i s0 = _mm256_xor_si256(
+                _mm256_xor_si256(_mm256_or_si256(_mm256_srli_epi32(w15, 7), _mm256_slli_epi32(w15, 25)),
+                                 _mm256_or_si256(_mm256_srli_epi32(w15, 18), _mm256_slli_epi32(w15, 14))),
+                _mm256_srli_epi32(w15, 3));
+            __m256i sum = _mm256_add_epi32(_mm256_add_epi32(w0, w7), s0);
+
+            __m256i w2lo = _mm256_shuffle_epi32(w3, _MM_SHUFFLE(3, 3, 3, 2));
+            __m256i s1 = _mm256_xor_si256(
+                _mm256_xor_si256(_mm256_or_si256(_mm256_srli_epi32(w2lo, 17), _mm256_slli_epi32(w2lo, 15)),
+                                 _mm256_or_si256(_mm256_srli_epi32(w2lo, 19), _mm256_slli_epi32(w2lo, 13))),
+                _mm256_srli_epi32(w2lo, 10));
+            sum = _mm256_add_epi32(sum, _mm256_and_si256(s1, _mm256_set_epi32(0, 0, -1, -1, 0, 0, -1, -1)));
+
+            __m256i w2hi = _mm256_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 1, 0));
+            s1 = _mm256_xor_si256(
+                _mm256_xor_si256(_mm256_or_si256(_mm256_srli_epi32(w2hi, 17), _mm256_slli_epi32(w2hi, 15)),
+                                 _mm256_or_si256(_mm256_srli_epi32(w2hi, 19), _mm256_slli_epi32(w2hi, 13))),
+                _mm256_srli_epi32(w2hi, 10));
+            return _mm256_add_epi32(sum, _mm256_and_si256(s1, _mm256_set_epi32(-1, -1, 0, 0, -1, -1, 0, 0)));
+        }
+
+        typedef uint32_t u32x4 __attribute__((vector_size(16)));
+        typedef uint32_t u32x8 __attribute__((vector_size(32)));
+
+        // Multi-buffer kernel: lane i of every vector belongs to message i.
+        // Written with GCC vector extensions and always inlined, so the same
+        // code becomes SSE2 or AVX2 depending on the wrapper's target.
+#define TIN_SHA256_LANE_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+        template <typename V, size_t L>
+        __attribute__((always_inline)) inline void compressLanes(V *state, const uint8_t *const *blocks)
+        {
+            V w[16];
+            for (int i = 0; i < 16; i++)
+            {
+                for (size_t lane = 0; lane < L; lane++)
+                {
+                    const uint8_t *p = blocks[lane] + i * 4;
+                    w[i][lane] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+                }
+            }
+
+            V a = state[0], b = state[1], c = state[2], d = state[3];
+            V e = state[4], f = state[5], g = state[6], h = state[7];
+
+            for (int t = 0; t < 64; t++)
+            {
+                if (t >= 16)
+                {
+                    V w15 = w[(t - 15) & 15];
+                    V w2 = w[(t - 2) & 15];
+                    w[t & 15] += (TIN_SHA256_LANE_ROR(w2, 17) ^ TIN_SHA256_LANE_ROR(w2, 19) ^ (w2 >> 10)) + w[(t - 7) & 15] +
+                                 (TIN_SHA256_LANE_ROR(w15, 7) ^ TIN_SHA256_LANE_ROR(w15, 18) ^ (w15 >> 3));
+                }
+
+                V t1 = h + (TIN_SHA256_LANE_ROR(e, 6) ^ TIN_SHA256_LANE_ROR(e, 11) ^ TIN_SHA256_LANE_ROR(e, 25)) + ((e & f) ^ (~e & g)) + SHA256::K[t] + w[t & 15];
+                V t2 = (TIN_SHA256_LANE_ROR(a, 2) ^ TIN_SHA256_LANE_ROR(a, 13) ^ TIN_SHA256_LANE_ROR(a, 22)) + ((a & (b | c)) | (b & c));
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+
+        // Feeds L messages through compressLanes. When a lane finishes its
+        // message it writes the digest and picks up the next one, so ragged
+        // lengths only cost the idle blocks at the very end.
+        template <typename V, size_t L>
+        __attribute__((always_inline)) inline void hashLanes(const ByteView *inputs, std::array<uint8_t, SHA256::DIGEST_LENGTH> *outputs, size_t count)
+        {
+            static const uint8_t idleBlock[64] = {0};
+
+            struct Lane
+            {
+                size_t job;
+                size_t block;
+                size_t fullBlocks;
+                size_t totalBlocks;
+                uint8_t tail[128];
+            };
+
+            Lane lane[L];
+            V state[8];
+            const uint8_t *blocks[L];
+            size_t nextJob = 0;
+            size_t active = 0;
+
+            auto start = [&](size_t i)
+            {
+                if (nextJob == count)
+                {
+                    lane[i].job = count;
+                    return;
+                }
+
+                Lane &ln = lane[i];
+                const ByteView &in = inputs[nextJob];
+                ln.job = nextJob++;
+                ln.block = 0;
+                ln.fullBlocks = in.size / 64;
+
+                size_t rem = in.size % 64;
+                size_t tailLen = rem < 56 ? 64 : 128;
+                if (rem > 0)
+                    std::memcpy(ln.tail, in.data + ln.fullBlocks * 64, rem);
+                std::memset(ln.tail + rem, 0, tailLen - rem);
+                ln.tail[rem] = 0x80;
+                uint64_t bits = uint64_t(in.size) * 8;
+                for (int j = 0; j < 8; j++)
+                {
+                    ln.tail[tailLen - 1 - j] = uint8_t(bits >> (j * 8));
+                }
+                ln.totalBlocks = ln.fullBlocks + tailLen / 64;
+
+                for (int j = 0; j < 8; j++)
+                {
+                    state[j][i] = SHA256::H0[j];
+                }
+                active++;
+            };
+
+            for (size_t i = 0; i < L; i++)
+            {
+                start(i);
+            }
+
+            while (active > 0)
+            {
+                for (size_t i = 0; i < L; i++)
+                {
+                    const Lane &ln = lane[i];
+                    if (ln.job == count)
+                        blocks[i] = idleBlock;
+                    else if (ln.block < ln.fullBlocks)
+                        blocks[i] = inputs[ln.job].data + ln.block * 64;
+                    else
+                        blocks[i] = ln.tail + (ln.block - ln.fullBlocks) * 64;
+                }
+
+                compressLanes<V, L>(state, blocks);
+
+                for (size_t i = 0; i < L; i++)
+                {
+                    Lane &ln = lane[i];
+                    if (ln.job == count || ++ln.block < ln.totalBlocks)
+                        continue;
+
+                    std::array<uint8_t, SHA256::DIGEST_LENGTH> &out = outputs[ln.job];
+                    for (int j = 0; j < 8; j++)
+                    {
+                        uint32_t word = state[j][i];
+                        out[j * 4] = word >> 24;
+                        out[j * 4 + 1] = word >> 16;
+                        out[j * 4 + 2] = word >> 8;
+                        out[j * 4 + 3] = word;
+                    }
+                    active--;
+                    start(i);
+                }
+            }
+        }
+    }
+
+    void SHA256::hashManySSE(const ByteView *inputs, std::array<uint8_t, DIGEST_LENGTH> *outputs, size_t count)
+    {
+        sha256_x86::hashLanes<sha256_x86::u32x4, 4>(inputs, outputs, count);
+    }
+
+    __attribute__((target("avx2"))) void SHA256::hashManyAVX2(const ByteView *inputs, std::array<uint8_t, DIGEST_LENGTH> *outputs, size_t count)
+    {
+        sha256_x86::hashLanes<sha256_x86::u32x8, 8>(inputs, outputs, count);
+    }
+
+#undef TIN_SHA256_LANE_ROR
+
+    __attribute__((target("ssse3"))) void SHA256::transformSSSE3(uint32_t *state, const uint8_t *blocks, size_t count)
+    {
+        const __m128i byteSwap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        alignas(16) uint32_t wk[64];
+
+        for (; count > 0; count--, blocks += 64)
+        {
+            __m128i w[4];
+            for (int i = 0; i < 4; i++)
+            {
+                w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks + i * 16)), byteSwap);
+                _mm_store_si128(reinterpret_cast<__m128i *>(wk + i * 4),
+                                _mm_add_epi32(w[i], _mm_loadu_si128(reinterpret_cast<const __m128i *>(K.data() + i * 4))));
+            }
+
+            for (int t = 16; t < 64; t += 4)
+            {
+                __m128i next = sha256_x86::schedule(w[0], w[1], w[2], w[3]);
+                w[0] = w[1];
+                w[1] = w[2];
+                w[2] = w[3];
+                w[3] = next;
+                _mm_store_si128(reinterpret_cast<__m128i *>(wk + t),
+                                _mm_add_epi32(next, _mm_loadu_si128(reinterpret_cast<const __m128i *>(K.data() + t))));
+            }
+
+            rounds(state, wk);
+        }
+    }
+
+    __attribute__((target("avx2"))) void SHA256::transformAVX2(uint32_t *state, const uint8_t *blocks, size_t count)
+    {
+        const __m256i byteSwap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                                 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        alignas(32) uint32_t wk0[64];
+        alignas(32) uint32_t wk1[64];
+
+        // Schedules two consecutive blocks per pass; the rounds stay serial
+        for (; count >= 2; count -= 2, blocks += 128)
+        {
+            __m256i w[4];
+            for (int i = 0; i < 4; i++)
+            {
+                __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks + i * 16));
+                __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks + 64 + i * 16));
+                w[i] = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), byteSwap);
+                __m256i wk = _mm256_add_epi32(w[i], _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(K.data() + i * 4))));
+                _mm_store_si128(reinterpret_cast<__m128i *>(wk0 + i * 4), _mm256_castsi256_si128(wk));
+                _mm_store_si128(reinterpret_cast<__m128i *>(wk1 + i * 4), _mm256_extracti128_si256(wk, 1));
+            }
+
+            for (int t = 16; t < 64; t += 4)
+            {
+                __m256i next = sha256_x86::schedule(w[0], w[1], w[2], w[3]);
+                w[0] = w[1];
+                w[1] = w[2];
+                w[2] = w[3];
+                w[3] = next;
+                __m256i wk = _mm256_add_epi32(next, _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(K.data() + t))));
+                _mm_store_si128(reinterpret_cast<__m128i *>(wk0 + t), _mm256_castsi256_si128(wk));
+                _mm_store_si128(reinterpret_cast<__m128i *>(wk1 + t), _mm256_extracti128_si256(wk, 1));
+            }
+
+            rounds(state, wk0);
+            rounds(state, wk1);
+        }
+
+        if (count > 0)
+        {
+            transformSSSE3(state, blocks, count);
+        }
+    }
+
+    __attribute__((target("sha,sse4.1"))) void SHA256::transformSHANI(uint32_t *state, const uint8_t *blocks, size_t count)
+    {
+        const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+        // sha256rnds2 wants the state as ABEF / CDGH
+        __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state)), 0xB1);
+        __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state + 4)), 0x1B);
+        __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+        state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+        for (; count > 0; count--, blocks += 64)
+        {
+            __m128i abefSave = state0;
+            __m128i cdghSave = state1;
+            __m128i msg[4];
+
+            for (int g = 0; g < 16; g++)
+            {
+                __m128i &cur = msg[g & 3];
+                if (g < 4)
+                {
+                    cur = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks + g * 16)), byteSwap);
+                }
+
+                __m128i wk = _mm_add_epi32(cur, _mm_loadu_si128(reinterpret_cast<const __m128i *>(K.data() + g * 4)));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+
+                if (g >= 3 && g <= 14)
+                {
+                    __m128i &next = msg[(g + 1) & 3];
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(cur, msg[(g + 3) & 3], 4));
+                    next = _mm_sha256msg2_epu32(next, cur);
+                }
+
+                state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0E));
+
+                if (g >= 1 && g <= 12)
+                {
+                    msg[(g + 3) & 3] = _mm_sha256msg1_epu32(msg[(g + 3) & 3], cur);
+                }
+            }
+
+            state0 = _mm_add_epi32(state0, abefSave);
+            state1 = _mm_add_epi32(state1, cdghSave);
+        }
+
+        tmp = _mm_shuffle_epi32(state0, 0x1B);
+        state1 = _mm_shuffle_epi32(state1, 0xB1);
+        state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+        state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(state), state0);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(state + 4), state1);
+    }
+}
+
+#endif
@@ -0,0 +1,224 @@
+#include "../SHA256File.hpp"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * SHA256 throughput suite. Prints one JSON document on stdout so runs from
+ * different commits can be diffed or fed to a script:
+ *
+ *   ./benchmark [--min-time SECONDS] [--files MAX_MB] [--file-path PATH]
+ *
+ * Every supported kernel is measured for one-shot updates, incremental
+ * updates (INCREMENTAL_CHUNK bytes per call), hashMany batches and, for
+ * 80-byte inputs, sha256d_80. --files adds cold-cache file hashing from
+ * 1 MB up to MAX_MB in both SHA256File modes.
+ */
+
+static const size_t INCREMENTAL_CHUNK = 31;
+static const size_t BATCH_SIZE = 1024;
+static volatile uint8_t sink;
+
+struct Result
+{
+    std::string name;
+    std::string implementation;
+    size_t size;
+    size_t iterations;
+    double seconds;
+};
+
+static std::vector<uint8_t> filler(size_t size)
+{
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        bytes[i] = i * 31 + 7;
+    }
+    return bytes;
+}
+
+// Runs `hashes` in a loop until minTime has passed; each call hashes
+// `perCall` messages of `size` bytes.
+static Result measure(const std::string &name, size_t size, size_t perCall, double minTime, const std::function<void()> &hashes)
+{
+    hashes();
+
+    size_t calls = 0;
+    double seconds = 0;
+    auto start = std::chrono::steady_clock::now();
+    do
+    {
+        hashes();
+        calls++;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < minTime);
+
+    return {name, tin::SHA256::implementationName(tin::SHA256::implementation()), size, calls * perCall, seconds};
+}
+
+static void benchmarkMemory(std::vector<Result> &results, double minTime)
+{
+    const size_t sizes[] = {32, 64, 80, 1024, 64 << 10, 16 << 20};
+
+    for (auto impl : {tin::SHA256::SCALAR, tin::SHA256::SSSE3, tin::SHA256::AVX2, tin::SHA256::SHANI})
+    {
+        if (!tin::SHA256::isSupported(impl))
+            continue;
+        tin::SHA256::setImplementation(impl);
+
+        for (size_t size : sizes)
+        {
+            std::vector<uint8_t> message = filler(size);
+
+            results.push_back(measure("oneshot", size, 1, minTime, [&]()
+                                      {
+                tin::SHA256 sha;
+                sha.update(message);
+                sink = sha.digest()[0]; }));
+
+            results.push_back(measure("incremental", size, 1, minTime, [&]()
+                                      {
+                tin::SHA256 sha;
+                for (size_t offset = 0; offset < size; offset += INCREMENTAL_CHUNK)
+                {
+                    sha.update(message.data() + offset, std::min(INCREMENTAL_CHUNK, size - offset));
+                }
+                sink = sha.digest()[0]; }));
+
+            if (size <= 64 << 10)
+            {
+                std::vector<tin::ByteView> batch(BATCH_SIZE, tin::ByteView(message));
+                std::vector<std::array<uint8_t, tin::SHA256::DIGEST_LENGTH>> digests(BATCH_SIZE);
+                results.push_back(measure("hashMany", size, BATCH_SIZE, minTime, [&]()
+                                          {
+                    tin::SHA256::hashMany(batch.data(), digests.data(), batch.size());
+                    sink = digests[0][0]; }));
+            }
+
+            if (size == 80)
+            {
+                results.push_back(measure("sha256d_80", size, 1, minTime, [&]()
+                                          { sink = tin::sha256d_80(message.data())[0]; }));
+            }
+        }
+    }
+}
+
+// Writes `size` bytes of filler to `path` and evicts it from the page cache,
+// so the timed hash has to go to the disk like a real block file would.
+static void writeColdFile(const std::string &path, size_t size)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Unable to create " + path);
+    }
+
+    std::vector<uint8_t> chunk = filler(1 << 20);
+    for (size_t written = 0; written < size;)
+    {
+        size_t n = std::min(chunk.size(), size - written);
+        if (write(fd, chunk.data(), n) != ssize_t(n))
+        {
+            close(fd);
+            throw std::runtime_error("Unable to write " + path);
+        }
+        written += n;
+    }
+
+    fsync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static void benchmarkFiles(std::vector<Result> &results, size_t maxMB, const std::string &path)
+{
+    const std::pair<tin::SHA256File::Mode, const char *> modes[] = {
+        {tin::SHA256File::MMAP, "file_mmap"},
+        {tin::SHA256File::BUFFERED, "file_buffered"}};
+
+    for (size_t mb = 1; mb <= maxMB; mb *= 8)
+    {
+        for (const auto &mode : modes)
+        {
+            writeColdFile(path, mb << 20);
+
+            auto start = std::chrono::steady_clock::now();
+            sink = tin::SHA256File::hash(path, mode.first)[0];
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            results.push_back({mode.second, tin::SHA256::implementationName(tin::SHA256::implementation()), mb << 20, 1, seconds});
+        }
+    }
+
+    unlink(path.c_str());
+}
+
+static void printJson(const std::vector<Result> &results, tin::SHA256::Implementation best)
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    oss << "{\n  \"benchmark\": \"sha256\",\n  \"default_implementation\": \""
+        << tin::SHA256::implementationName(best) << "\",\n  \"results\": [";
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result &r = results[i];
+        double bytes = double(r.size) * r.iterations;
+        oss << (i == 0 ? "\n" : ",\n")
+            << "    {\"name\": \"" << r.name << "\""
+            << ", \"implementation\": \"" << r.implementation << "\""
+            << ", \"size\": " << r.size
+            << ", \"iterations\": " << r.iterations
+            << ", \"seconds\": " << std::setprecision(6) << r.seconds << std::setprecision(2)
+            << ", \"mb_per_s\": " << bytes / 1e6 / r.seconds
+            << ", \"hashes_per_s\": " << r.iterations / r.seconds << "}";
+    }
+
+    oss << "\n  ]\n}";
+    std::cout << oss.str() << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    double minTime = 0.2;
+    size_t fileMaxMB = 0;
+    std::string filePath = "sha256_bench.tmp";
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--min-time") == 0)
+            minTime = std::strtod(argv[i + 1], nullptr);
+        else if (std::strcmp(argv[i], "--files") == 0)
+            fileMaxMB = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--file-path") == 0)
+            filePath = argv[i + 1];
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--min-time SECONDS] [--files MAX_MB] [--file-path PATH]" << std::endl;
+            return 1;
+        }
+    }
+
+    tin::SHA256::Implementation best = tin::SHA256::implementation();
+    std::vector<Result> results;
+
+    benchmarkMemory(results, minTime);
+    tin::SHA256::setImplementation(best);
+    if (fileMaxMB > 0)
+    {
+        benchmarkFiles(results, fileMaxMB, filePath);
+    }
+
+    printJson(results, best);
+    return 0;
+}
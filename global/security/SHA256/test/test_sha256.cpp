@@ -0,0 +1,218 @@
+#include "../SHA256.hpp"
+#include "../SHA256File.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <string>
+
+static std::string hashString(const std::string &data)
+{
+    tin::SHA256 sha;
+    sha.update(data);
+    return tin::SHA256::toString(sha.digest());
+}
+
+static std::vector<uint8_t> pseudoRandomBytes(size_t length, uint32_t seed)
+{
+    std::vector<uint8_t> bytes(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        bytes[i] = seed >> 16;
+    }
+    return bytes;
+}
+
+static std::vector<tin::SHA256::Implementation> supportedImplementations()
+{
+    std::vector<tin::SHA256::Implementation> impls;
+    for (auto impl : {tin::SHA256::SCALAR, tin::SHA256::SSSE3, tin::SHA256::AVX2, tin::SHA256::SHANI})
+    {
+        if (tin::SHA256::isSupported(impl))
+        {
+            impls.push_back(impl);
+        }
+    }
+    return impls;
+}
+
+void test_knownAnswers()
+{
+    for (auto impl : supportedImplementations())
+    {
+        tin::SHA256::setImplementation(impl);
+        assert(tin::SHA256::implementation() == impl);
+
+        assert(hashString("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        assert(hashString("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        assert(hashString("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+               "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+        assert(hashString("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu") ==
+               "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1");
+        assert(hashString(std::string(1000000, 'a')) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+        std::cout << "known answers ok: " << tin::SHA256::implementationName(impl) << std::endl;
+    }
+}
+
+void test_implementationsAgree()
+{
+    auto impls = supportedImplementations();
+
+    for (size_t length = 0; length < 600; length += 7)
+    {
+        std::vector<uint8_t> message = pseudoRandomBytes(length, length + 1);
+
+        tin::SHA256::setImplementation(tin::SHA256::SCALAR);
+        tin::SHA256 reference;
+        reference.update(message);
+        auto expected = reference.digest();
+
+        for (auto impl : impls)
+        {
+            tin::SHA256::setImplementation(impl);
+            tin::SHA256 sha;
+            sha.update(message);
+            assert(sha.digest() == expected);
+        }
+    }
+}
+
+void test_hashMany()
+{
+    // Ragged lengths around the one/two padding block boundary
+    std::vector<std::vector<uint8_t>> messages;
+    for (size_t i = 0; i < 61; i++)
+    {
+        size_t length = (i * 37) % 300;
+        if (i % 5 == 0)
+            length = 55 + i % 3;
+        messages.push_back(pseudoRandomBytes(length, i * 11 + 3));
+    }
+
+    std::vector<tin::ByteView> views(messages.begin(), messages.end());
+
+    for (auto impl : supportedImplementations())
+    {
+        tin::SHA256::setImplementation(impl);
+        // The cached lane width follows the kernel
+        if (impl == tin::SHA256::SCALAR)
+            assert(tin::SHA256::lanes() == 1);
+        auto digests = tin::SHA256::hashMany(views);
+        assert(digests.size() == messages.size());
+
+        for (size_t i = 0; i < messages.size(); i++)
+        {
+            tin::SHA256 sha;
+            sha.update(messages[i]);
+            assert(digests[i] == sha.digest());
+        }
+        std::cout << "hashMany ok: " << tin::SHA256::implementationName(impl)
+                  << " (" << tin::SHA256::lanes() << " lanes)" << std::endl;
+    }
+}
+
+void test_chunkedUpdate()
+{
+    std::vector<uint8_t> message = pseudoRandomBytes(1000, 42);
+    tin::SHA256 reference;
+    reference.update(message);
+    auto expected = reference.digest();
+
+    for (auto impl : supportedImplementations())
+    {
+        tin::SHA256::setImplementation(impl);
+        for (size_t chunk : {1, 3, 63, 64, 65, 127, 128, 200, 999})
+        {
+            tin::SHA256 sha;
+            for (size_t offset = 0; offset < message.size(); offset += chunk)
+            {
+                sha.update(message.data() + offset, std::min(chunk, message.size() - offset));
+            }
+            assert(sha.digest() == expected);
+        }
+    }
+}
+
+void test_checkpointRestore()
+{
+    std::vector<uint8_t> prefix = pseudoRandomBytes(100, 7);
+    tin::SHA256 sha;
+    sha.update(tin::ByteView(prefix));
+    tin::SHA256::State saved = sha.checkpoint();
+
+    for (const std::string &suffix : std::vector<std::string>{"", "a", "nonce=1", std::string(130, 'x')})
+    {
+        sha.restore(saved).update(suffix);
+
+        tin::SHA256 full;
+        full.update(prefix).update(suffix);
+        assert(sha.digest() == full.digest());
+    }
+}
+
+void test_sha256d_80()
+{
+    for (auto impl : supportedImplementations())
+    {
+        tin::SHA256::setImplementation(impl);
+        for (uint32_t seed = 0; seed < 20; seed++)
+        {
+            std::vector<uint8_t> header = pseudoRandomBytes(80, seed);
+
+            tin::SHA256 first;
+            first.update(header);
+            tin::SHA256 second;
+            second.update(first.digest());
+            auto expected = second.digest();
+
+            assert(tin::sha256d_80(header.data()) == expected);
+
+            tin::SHA256 prefix;
+            prefix.update(header.data(), 64);
+            assert(tin::sha256d_80(prefix.checkpoint(), header.data() + 64) == expected);
+        }
+    }
+}
+
+void test_fileHash()
+{
+    const std::string path = "sha256_test.tmp";
+
+    // Spans several windows and ends mid-block
+    std::vector<uint8_t> content = pseudoRandomBytes(2 * tin::SHA256File::WINDOW_SIZE + 1234, 99);
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(content.data()), content.size());
+
+    tin::SHA256 sha;
+    sha.update(content);
+    auto expected = sha.digest();
+
+    assert(tin::SHA256File::hash(path) == expected);
+    assert(tin::SHA256File::hash(path, tin::SHA256File::MMAP) == expected);
+    assert(tin::SHA256File::hash(path, tin::SHA256File::BUFFERED) == expected);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc).close();
+    assert(tin::SHA256::toString(tin::SHA256File::hash(path)) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    auto best = tin::SHA256::implementation();
+    std::cout << "default implementation: " << tin::SHA256::implementationName(best) << std::endl;
+
+    test_knownAnswers();
+    test_implementationsAgree();
+    test_hashMany();
+    test_chunkedUpdate();
+    test_checkpointRestore();
+    test_sha256d_80();
+    test_fileHash();
+
+    tin::SHA256::setImplementation(best);
+    std::cout << "All SHA256 tests passed" << std::endl;
+    return 0;
+}
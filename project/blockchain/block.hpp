@@ -5,10 +5,10 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
-#include <fstream>
 #include "transaction.hpp"
 #include "blockheader.hpp"
 #include "merkleTree.hpp"
+#include "miner.hpp"
 
 namespace tin_blockchain
 {
@@ -21,20 +21,80 @@ namespace tin_blockchain
         Block(const BlockHeader &header, const std::vector<Transaction> &transactions)
             : header(header), transactions(transactions) {}
 
-        std::string toString() const
+        // Wire format: 80-byte binary header | transaction count (varint) | transactions
+        size_t serializedSize() const
+        {
+            size_t size = BlockHeader::SIZE + encoding::varintSize(transactions.size());
+            for (const auto &tx : transactions)
+            {
+                size += tx.serializedSize();
+            }
+            return size;
+        }
+
+        uint8_t *serialize(uint8_t *buffer) const
+        {
+            header.serializeBinary(buffer);
+            encoding::Writer writer(buffer + BlockHeader::SIZE);
+            writer.varint(transactions.size());
+            for (const auto &tx : transactions)
+            {
+                tx.serialize(writer);
+            }
+            return writer.position();
+        }
+
+        std::vector<uint8_t> serialize() const
+        {
+            std::vector<uint8_t> buffer(serializedSize());
+            serialize(buffer.data());
+            return buffer;
+        }
+
+        // Throws std::invalid_argument on malformed or trailing bytes
+        static Block deserialize(const uint8_t *data, size_t size)
+        {
+            if (size < BlockHeader::SIZE)
+            {
+                throw std::invalid_argument("Truncated block header");
+            }
+
+            encoding::Reader reader(data + BlockHeader::SIZE, size - BlockHeader::SIZE);
+            uint64_t count = reader.varint();
+            std::vector<Transaction> transactions;
+            transactions.reserve(std::min<uint64_t>(count, reader.remaining()));
+            for (uint64_t i = 0; i < count; i++)
+            {
+                transactions.push_back(Transaction::deserialize(reader));
+            }
+            if (reader.remaining() != 0)
+            {
+                throw std::invalid_argument("Trailing bytes after block");
+            }
+            return Block(BlockHeader::deserializeBinary(data), transactions);
+        }
+
+        // Streams the block one transaction at a time; several blocks can be
+        // written into one array of a JsonWriter to export a chain
+        template <typename Sink>
+        void writeJson(JsonWriter<Sink> &json) const
         {
-            std::ostringstream oss;
-            oss << "{"
-                << "\"header\": " << header.toString()
-                << ", \"transactions\": [";
-            for (size_t i = 0; i < transactions.size(); ++i)
+            json.beginObject().key("header");
+            header.writeJson(json);
+            json.key("transactions").beginArray();
+            for (const auto &tx : transactions)
             {
-                oss << transactions[i].toString();
-                if (i < transactions.size() - 1)
-                    oss << ", ";
+                tx.writeJson(json);
             }
-            oss << "]}";
-            return oss.str();
+            json.endArray().endObject();
+        }
+
+        std::string toString() const
+        {
+            StringSink sink;
+            JsonWriter<StringSink> json(sink);
+            writeJson(json);
+            return sink.str;
         }
 
         void printBlock() const
@@ -44,26 +104,53 @@ namespace tin_blockchain
 
         void writeToJsonFile(const std::string &filename) const
         {
-            std::ofstream file(filename);
-            if (file.is_open())
+            try
             {
-                file << toString();
-                file.close();
+                FdSink sink(filename);
+                JsonWriter<FdSink> json(sink);
+                writeJson(json);
+                json.flush();
                 std::cout << "Block written to " << filename << std::endl;
             }
-            else
+            catch (const std::runtime_error &e)
             {
-                std::cerr << "Unable to open file " << filename << std::endl;
+                std::cerr << e.what() << std::endl;
             }
         }
+
         std::string mine()
         {
-            std::string target(header.difficulty, '0');
-            while (header.computeHash().substr(0, header.difficulty) != target)
+            // Only the nonce bytes of the tail change between attempts
+            const tin::SHA256::State midstate = header.midstate();
+            const Target target = header.target();
+            uint8_t tail[BlockHeader::TAIL_SIZE];
+            header.serializeTail(tail);
+
+            SHAHash digest = tin::sha256d_80(midstate, tail);
+            while (!target.isMetBy(digest))
             {
                 header.nonce++;
+                BlockHeader::setTailNonce(tail, header.nonce);
+                digest = tin::sha256d_80(midstate, tail);
+            }
+
+            std::string hash = digest.toString();
+            header.setHash(hash);
+            return hash;
+        }
+
+        // Parallel search starting at options.startNonce. On success the
+        // header takes the winning nonce and hash, exactly as mine() would
+        // have left them.
+        Miner::Result mine(const Miner::Options &options)
+        {
+            Miner::Result result = Miner::mine(header, options);
+            if (result.found)
+            {
+                header.nonce = result.nonce;
+                header.setHash(result.hash);
             }
-            return header.computeHash();
+            return result;
         }
     };
 }
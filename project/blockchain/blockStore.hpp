@@ -0,0 +1,456 @@
+#ifndef BLOCKCHAIN_BLOCK_STORE
+#define BLOCKCHAIN_BLOCK_STORE
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "block.hpp"
+#include "mappedFile.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * Append-only block storage in a directory:
+     *
+     *   blkNNNNN.dat  segment files, blocks in wire format back to back
+     *   heights.idx   height -> (segment, offset, size), 16 bytes per block
+     *   txids.idx     open-addressing table txid -> (height, offset, size)
+     *
+     * Both indexes are memory-mapped, so opening a store reads two headers
+     * and never replays the chain. A block lookup is one index page and one
+     * pread; a transaction lookup is one or two table pages (linear probing
+     * at <= 70% load) and one pread of just the transaction's bytes.
+     *
+     * Appends go to the page cache; sync() makes them durable, and runs by
+     * itself every Options::syncInterval blocks. The heights header records
+     * how many blocks were synced, and that count is what a reopened store
+     * trusts: segment tails past it are truncated, and after an unclean
+     * shutdown txid entries for higher heights are dropped. Index files are
+     * in host byte order; they are local to the node.
+     */
+    class BlockStore
+    {
+    public:
+        struct Options
+        {
+            size_t segmentSize = 128 << 20;
+            size_t syncInterval = 64;
+        };
+
+        struct Location
+        {
+            uint32_t segment;
+            uint32_t size;
+            uint64_t offset;
+        };
+
+        // `offset` is relative to the start of the block
+        struct TxLocation
+        {
+            uint32_t height;
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        explicit BlockStore(const std::string &directory) : BlockStore(directory, Options()) {}
+
+        BlockStore(const std::string &directory, const Options &options)
+            : directory(directory), options(options)
+        {
+            std::filesystem::create_directories(directory);
+            openHeights();
+            openTxids();
+            openSegments();
+        }
+
+        ~BlockStore()
+        {
+            try
+            {
+                sync();
+                txidHeader().dirty = 0;
+                txids->sync(0, sizeof(TxidHeader));
+            }
+            catch (const std::runtime_error &e)
+            {
+                std::cerr << e.what() << std::endl;
+            }
+            for (int fd : segments)
+                close(fd);
+        }
+
+        BlockStore(const BlockStore &) = delete;
+        BlockStore &operator=(const BlockStore &) = delete;
+
+        // Number of blocks stored; the next append gets this height
+        uint32_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        uint32_t syncedSize() const { return uint32_t(heightHeader().synced); }
+
+        // Appends `block` at height size() and returns that height
+        uint32_t append(const Block &block)
+        {
+            buffer.resize(block.serializedSize());
+            block.serialize(buffer.data());
+            if (buffer.size() > UINT32_MAX)
+                throw std::invalid_argument("Block larger than 4 GiB");
+
+            if (segmentEnd > 0 && segmentEnd + buffer.size() > options.segmentSize)
+                startSegment(uint32_t(segments.size()));
+
+            Location location{uint32_t(segments.size() - 1), uint32_t(buffer.size()), segmentEnd};
+            writeAll(segments.back(), buffer.data(), buffer.size(), segmentEnd);
+            segmentEnd += buffer.size();
+
+            // Any txid entries past the synced height are garbage after a
+            // crash; flag the table before the first such entry can land
+            if (!txidHeader().dirty)
+            {
+                txidHeader().dirty = 1;
+                txids->sync(0, sizeof(TxidHeader));
+            }
+
+            uint32_t height = count;
+            heights->reserve(HEIGHTS_HEADER + (size_t(height) + 1) * sizeof(Location));
+            std::memcpy(heights->data() + HEIGHTS_HEADER + size_t(height) * sizeof(Location), &location, sizeof(location));
+
+            uint32_t offset = uint32_t(BlockHeader::SIZE + encoding::varintSize(block.transactions.size()));
+            for (const auto &tx : block.transactions)
+            {
+                uint32_t txSize = uint32_t(tx.serializedSize());
+                insertTxid(tx.txid, TxSlot{{}, height + 1, offset, txSize, 0});
+                offset += txSize;
+            }
+
+            count++;
+            if (count - syncedSize() >= options.syncInterval)
+                sync();
+            return height;
+        }
+
+        Location location(uint32_t height) const
+        {
+            if (height >= count)
+                throw std::out_of_range("No block at height " + std::to_string(height));
+            Location location;
+            std::memcpy(&location, heights->data() + HEIGHTS_HEADER + size_t(height) * sizeof(Location), sizeof(location));
+            return location;
+        }
+
+        // Reads the wire bytes of the block at `height` into `out`, which can
+        // be reused between calls (for example with BlockView)
+        void readBlock(uint32_t height, std::vector<uint8_t> &out) const
+        {
+            Location at = location(height);
+            out.resize(at.size);
+            readAll(segments[at.segment], out.data(), at.size, at.offset);
+        }
+
+        Block block(uint32_t height) const
+        {
+            std::vector<uint8_t> bytes;
+            readBlock(height, bytes);
+            return Block::deserialize(bytes.data(), bytes.size());
+        }
+
+        bool findTransaction(const SHAHash &txid, TxLocation &out) const
+        {
+            const TxSlot *slot = findSlot(txid);
+            if (!slot)
+                return false;
+            out = TxLocation{slot->heightPlusOne - 1, slot->offset, slot->size};
+            return true;
+        }
+
+        // Throws std::out_of_range if the txid is not stored
+        Transaction transaction(const SHAHash &txid) const
+        {
+            TxLocation at;
+            if (!findTransaction(txid, at))
+                throw std::out_of_range("Unknown transaction " + txid.toString());
+
+            Location block = location(at.height);
+            std::vector<uint8_t> bytes(at.size);
+            readAll(segments[block.segment], bytes.data(), at.size, block.offset + at.offset);
+            return Transaction::deserialize(bytes.data(), bytes.size());
+        }
+
+        // Makes every appended block durable: segments first, then the
+        // indexes, and only then the synced count that reopening trusts
+        void sync()
+        {
+            uint32_t synced = syncedSize();
+            if (synced == count)
+                return;
+
+            uint32_t firstSegment = synced > 0 ? location(synced - 1).segment : 0;
+            for (size_t i = firstSegment; i < segments.size(); i++)
+            {
+                if (fsync(segments[i]) != 0)
+                    throw std::runtime_error("Unable to sync " + segmentPath(uint32_t(i)) + ": " + std::strerror(errno));
+            }
+
+            heights->sync(HEIGHTS_HEADER + size_t(synced) * sizeof(Location), size_t(count - synced) * sizeof(Location));
+            txids->sync();
+
+            heightHeader().synced = count;
+            heights->sync(0, HEIGHTS_HEADER);
+        }
+
+        // Bytes of index per stored block and per transaction, for sizing
+        static constexpr size_t HEIGHT_ENTRY_SIZE = sizeof(Location);
+        static constexpr size_t TXID_SLOT_SIZE = 48;
+
+    private:
+        static constexpr uint64_t HEIGHTS_MAGIC = 0x31305448474e4954ULL; // "TINGHT01"
+        static constexpr uint64_t TXIDS_MAGIC = 0x3130444958544e54ULL;   // "TNTXID01"
+        static constexpr size_t HEIGHTS_HEADER = 64;
+        static constexpr size_t TXIDS_HEADER = 64;
+        static constexpr uint64_t INITIAL_SLOTS = 1 << 14;
+
+        struct HeightHeader
+        {
+            uint64_t magic;
+            uint64_t synced;
+        };
+
+        struct TxidHeader
+        {
+            uint64_t magic;
+            uint64_t capacity;
+            uint64_t used;
+            uint64_t dirty;
+        };
+
+        // heightPlusOne == 0 marks an empty slot
+        struct TxSlot
+        {
+            uint8_t txid[SHAHash::LENGTH];
+            uint32_t heightPlusOne;
+            uint32_t offset;
+            uint32_t size;
+            uint32_t reserved;
+        };
+        static_assert(sizeof(TxSlot) == TXID_SLOT_SIZE, "TxSlot must stay packed");
+        static_assert(sizeof(Location) == 16, "Location must stay packed");
+
+        std::string directory;
+        Options options;
+        std::unique_ptr<MappedRegion> heights;
+        std::unique_ptr<MappedRegion> txids;
+        std::vector<int> segments;
+        uint64_t segmentEnd = 0;
+        uint32_t count = 0;
+        std::vector<uint8_t> buffer;
+
+        HeightHeader &heightHeader() { return *reinterpret_cast<HeightHeader *>(heights->data()); }
+        const HeightHeader &heightHeader() const { return *reinterpret_cast<const HeightHeader *>(heights->data()); }
+        TxidHeader &txidHeader() { return *reinterpret_cast<TxidHeader *>(txids->data()); }
+        const TxidHeader &txidHeader() const { return *reinterpret_cast<const TxidHeader *>(txids->data()); }
+
+        TxSlot *slots() { return reinterpret_cast<TxSlot *>(txids->data() + TXIDS_HEADER); }
+        const TxSlot *slots() const { return reinterpret_cast<const TxSlot *>(txids->data() + TXIDS_HEADER); }
+
+        std::string indexPath(const char *name) const { return directory + "/" + name; }
+
+        std::string segmentPath(uint32_t segment) const
+        {
+            char name[24];
+            std::snprintf(name, sizeof(name), "blk%05u.dat", segment);
+            return directory + "/" + name;
+        }
+
+        void openHeights()
+        {
+            heights.reset(new MappedRegion(indexPath("heights.idx"), HEIGHTS_HEADER + 1024 * sizeof(Location)));
+            if (heights->isNew())
+                heightHeader().magic = HEIGHTS_MAGIC;
+            else if (heightHeader().magic != HEIGHTS_MAGIC)
+                throw std::runtime_error(indexPath("heights.idx") + " is not a height index");
+            count = uint32_t(heightHeader().synced);
+        }
+
+        void openTxids()
+        {
+            std::string path = indexPath("txids.idx");
+            txids.reset(new MappedRegion(path, TXIDS_HEADER + INITIAL_SLOTS * sizeof(TxSlot)));
+            if (txids->isNew())
+            {
+                txidHeader() = TxidHeader{TXIDS_MAGIC, INITIAL_SLOTS, 0, 0};
+                return;
+            }
+            if (txidHeader().magic != TXIDS_MAGIC)
+                throw std::runtime_error(path + " is not a txid index");
+            if (txidHeader().dirty)
+            {
+                rebuildTxids(txidHeader().capacity, count);
+                txidHeader().dirty = 0;
+            }
+        }
+
+        // Keeps the synced blocks' bytes and drops anything appended after
+        void openSegments()
+        {
+            uint32_t keep = 0;
+            uint64_t end = 0;
+            if (count > 0)
+            {
+                Location last = location(count - 1);
+                keep = last.segment + 1;
+                end = last.offset + last.size;
+            }
+
+            for (uint32_t i = 0; i < keep; i++)
+            {
+                int fd = open(segmentPath(i).c_str(), O_RDWR);
+                if (fd < 0)
+                    throw std::runtime_error("Unable to open " + segmentPath(i) + ": " + std::strerror(errno));
+                segments.push_back(fd);
+            }
+            for (uint32_t i = keep; std::filesystem::exists(segmentPath(i)); i++)
+            {
+                std::filesystem::remove(segmentPath(i));
+            }
+
+            if (keep == 0)
+            {
+                startSegment(0);
+                return;
+            }
+            if (ftruncate(segments.back(), end) != 0)
+                throw std::runtime_error("Unable to truncate " + segmentPath(keep - 1) + ": " + std::strerror(errno));
+            segmentEnd = end;
+        }
+
+        void startSegment(uint32_t segment)
+        {
+            int fd = open(segmentPath(segment).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0)
+                throw std::runtime_error("Unable to create " + segmentPath(segment) + ": " + std::strerror(errno));
+            segments.push_back(fd);
+            segmentEnd = 0;
+        }
+
+        static void writeAll(int fd, const uint8_t *data, size_t size, uint64_t offset)
+        {
+            while (size > 0)
+            {
+                ssize_t n = pwrite(fd, data, size, offset);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    throw std::runtime_error(std::string("Unable to write block: ") + std::strerror(errno));
+                data += n;
+                size -= n;
+                offset += n;
+            }
+        }
+
+        static void readAll(int fd, uint8_t *data, size_t size, uint64_t offset)
+        {
+            while (size > 0)
+            {
+                ssize_t n = pread(fd, data, size, offset);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    throw std::runtime_error(std::string("Unable to read block: ") + std::strerror(n < 0 ? errno : EIO));
+                data += n;
+                size -= n;
+                offset += n;
+            }
+        }
+
+        // Txids are uniformly distributed, so their first bytes are the hash
+        static uint64_t slotHash(const uint8_t *txid)
+        {
+            uint64_t h;
+            std::memcpy(&h, txid, sizeof(h));
+            return h;
+        }
+
+        const TxSlot *findSlot(const SHAHash &txid) const
+        {
+            const TxSlot *table = slots();
+            uint64_t mask = txidHeader().capacity - 1;
+            for (uint64_t i = slotHash(txid.data()) & mask;; i = (i + 1) & mask)
+            {
+                const TxSlot &slot = table[i];
+                if (slot.heightPlusOne == 0)
+                    return nullptr;
+                if (std::memcmp(slot.txid, txid.data(), SHAHash::LENGTH) == 0)
+                    return slot.heightPlusOne <= count ? &slot : nullptr;
+            }
+        }
+
+        // A txid stored twice (a duplicated transaction) points at the later block
+        void insertTxid(const SHAHash &txid, TxSlot entry)
+        {
+            // The block being appended is not counted yet, so keep its
+            // entries by height rather than by `count`
+            if ((txidHeader().used + 1) * 10 > txidHeader().capacity * 7)
+                rebuildTxids(txidHeader().capacity * 2, entry.heightPlusOne);
+
+            std::memcpy(entry.txid, txid.data(), SHAHash::LENGTH);
+            TxSlot *table = slots();
+            uint64_t mask = txidHeader().capacity - 1;
+            for (uint64_t i = slotHash(entry.txid) & mask;; i = (i + 1) & mask)
+            {
+                TxSlot &slot = table[i];
+                if (slot.heightPlusOne == 0)
+                {
+                    slot = entry;
+                    txidHeader().used++;
+                    return;
+                }
+                if (std::memcmp(slot.txid, entry.txid, SHAHash::LENGTH) == 0)
+                {
+                    slot = entry;
+                    return;
+                }
+            }
+        }
+
+        // Rehashes the entries of heights below `keepThrough` into a fresh
+        // table of `capacity` slots, written beside the old one and renamed
+        // over it. Entries at or past `keepThrough` are dropped.
+        void rebuildTxids(uint64_t capacity, uint32_t keepThrough)
+        {
+            std::string path = indexPath("txids.idx");
+            std::string temp = path + ".tmp";
+            std::filesystem::remove(temp);
+
+            std::unique_ptr<MappedRegion> rebuilt(new MappedRegion(temp, TXIDS_HEADER + capacity * sizeof(TxSlot)));
+            TxidHeader *header = reinterpret_cast<TxidHeader *>(rebuilt->data());
+            *header = TxidHeader{TXIDS_MAGIC, capacity, 0, txidHeader().dirty};
+
+            TxSlot *table = reinterpret_cast<TxSlot *>(rebuilt->data() + TXIDS_HEADER);
+            const TxSlot *old = slots();
+            for (uint64_t i = 0; i < txidHeader().capacity; i++)
+            {
+                if (old[i].heightPlusOne == 0 || old[i].heightPlusOne > keepThrough)
+                    continue;
+                uint64_t j = slotHash(old[i].txid) & (capacity - 1);
+                while (table[j].heightPlusOne != 0)
+                    j = (j + 1) & (capacity - 1);
+                table[j] = old[i];
+                header->used++;
+            }
+
+            rebuilt->sync();
+            std::filesystem::rename(temp, path);
+            txids = std::move(rebuilt);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,369 @@
+#ifndef BLOCKCHAIN_BLOCK_VALIDATOR
+#define BLOCKCHAIN_BLOCK_VALIDATOR
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+#include "block.hpp"
+#include "utxoSet.hpp"
+#include "transactionGraph.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * Checks a received block against the UTXO set it would be applied to:
+     *
+     *   PROOF_OF_WORK     header.hash is the header's digest and meets difficulty
+     *   TRANSACTION_HASH  every txid/hash matches a fresh hash of the transaction
+     *   INPUTS            every input names an unspent output (in the set, or
+     *                     created by an earlier transaction of the block) with
+     *                     the same value and address, none is spent twice,
+     *                     no transaction pays out more than it takes in, and
+     *                     no output is already in the set. Only the first
+     *                     transaction (the coinbase) may have no inputs,
+     *                     except in a genesis block (empty previousHash),
+     *                     which bootstraps the coins.
+     *   MERKLE_ROOT       header.merkleRoot is the root of the txids
+     *
+     * The proof of work is one hash and runs first. Transactions are then
+     * checked wave by wave over the block's TransactionGraph, each wave as
+     * a parallelFor (inline when it fits one grain). A transaction that
+     * passes publishes its outputs to a block-local layer. Spends of
+     * in-block outputs are looked up there, so a wave only sees what the
+     * waves before it created. Which input of an outpoint spent twice is
+     * the second one is fixed up front, in block order. Once a transaction
+     * fails only earlier positions are still checked, so the result (stage,
+     * position and message) is exactly what validateSequential() returns.
+     * The Merkle tree is built on the same pool.
+     */
+    class BlockValidator
+    {
+    public:
+        static const size_t PARALLEL_GRAIN = 64;
+
+        enum Stage
+        {
+            NONE,
+            PROOF_OF_WORK,
+            TRANSACTION_HASH,
+            INPUTS,
+            MERKLE_ROOT
+        };
+
+        struct Result
+        {
+            bool valid = true;
+            Stage stage = NONE;
+            size_t transaction = 0; // position in the block, for per-transaction stages
+            std::string error;
+        };
+
+        struct Stats
+        {
+            uint64_t blocks = 0;
+            uint64_t transactions = 0;
+            double seconds = 0;
+
+            double blocksPerSecond() const { return seconds > 0 ? blocks / seconds : 0; }
+            double transactionsPerSecond() const { return seconds > 0 ? transactions / seconds : 0; }
+        };
+
+        explicit BlockValidator(tin::ThreadPool &pool = tin::ThreadPool::shared()) : pool(pool) {}
+
+        static const char *stageName(Stage stage)
+        {
+            switch (stage)
+            {
+            case PROOF_OF_WORK:
+                return "proof of work";
+            case TRANSACTION_HASH:
+                return "transaction hash";
+            case INPUTS:
+                return "inputs";
+            case MERKLE_ROOT:
+                return "merkle root";
+            default:
+                return "none";
+            }
+        }
+
+        Result validate(const Block &block, const UtxoSet &utxos)
+        {
+            auto start = std::chrono::steady_clock::now();
+            Result result = check(block, utxos, true);
+            record(block, start);
+            return result;
+        }
+
+        // The same checks one transaction at a time in block order, stopping
+        // at the first failure; validate() always returns the same Result
+        Result validateSequential(const Block &block, const UtxoSet &utxos)
+        {
+            auto start = std::chrono::steady_clock::now();
+            Result result = check(block, utxos, false);
+            record(block, start);
+            return result;
+        }
+
+        // Validates and, if valid, applies the block to `utxos`; this is one
+        // step of initial sync. A valid block always applies cleanly.
+        Result connect(const Block &block, UtxoSet &utxos, UtxoSet::BlockUndo &undoData)
+        {
+            auto start = std::chrono::steady_clock::now();
+            Result result = check(block, utxos, true);
+            if (result.valid)
+                utxos.apply(block, undoData);
+            record(block, start);
+            return result;
+        }
+
+        // Totals over every validate()/connect() call
+        const Stats &stats() const { return totals; }
+        void resetStats() { totals = Stats(); }
+
+    private:
+        tin::ThreadPool &pool;
+        Stats totals;
+
+        // Shared by the chunks of one check(); keeps the earliest failure
+        class Failure
+        {
+        public:
+            // Position of the earliest failure so far, or SIZE_MAX
+            size_t position() const { return first.load(std::memory_order_relaxed); }
+
+            void raise(const Result &failed)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!result.valid && result.transaction <= failed.transaction)
+                    return;
+                result = failed;
+                first.store(failed.transaction, std::memory_order_relaxed);
+            }
+
+            Result take() { return result; }
+
+        private:
+            std::atomic<size_t> first{SIZE_MAX};
+            std::mutex mutex;
+            Result result;
+        };
+
+        // An output created in the block, published once its transaction
+        // passes
+        struct LayerOutput
+        {
+            double value = 0;
+            const std::string *addr = nullptr; // null until published
+        };
+
+        // Everything a transaction check reads besides the transaction
+        struct Context
+        {
+            const std::vector<Transaction> &transactions;
+            const TransactionGraph &graph;
+            const UtxoSet &utxos;
+            bool genesis;
+            // Per input, flattened in block order: spends an outpoint that an
+            // earlier input of the block already spent
+            std::vector<uint8_t> spentBefore;
+            std::vector<size_t> inputStart;
+            // Per output, flattened in block order. Each transaction writes
+            // only its own entries, and only later waves read them.
+            std::vector<LayerOutput> layer;
+            std::vector<size_t> outputStart;
+            std::vector<SHAHash> txids;
+        };
+
+        void record(const Block &block, std::chrono::steady_clock::time_point start)
+        {
+            totals.blocks++;
+            totals.transactions += block.transactions.size();
+            totals.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        Result check(const Block &block, const UtxoSet &utxos, bool parallel)
+        {
+            const BlockHeader &header = block.header;
+            SHAHash digest = header.computeDigest();
+            if (!header.meetsDifficulty(digest))
+                return Result{false, PROOF_OF_WORK, 0, "Header hash does not meet difficulty " + std::to_string(header.difficulty)};
+            if (!matchesHex(digest, header.hash))
+                return Result{false, PROOF_OF_WORK, 0, "Header hash field is not the header's hash"};
+
+            const std::vector<Transaction> &transactions = block.transactions;
+            TransactionGraph graph(transactions);
+            Context context{transactions, graph, utxos, header.previousHash.empty(), {}, {}, {}, {}, std::vector<SHAHash>(transactions.size())};
+            markDoubleSpends(context);
+            context.outputStart.resize(transactions.size() + 1, 0);
+            for (size_t i = 0; i < transactions.size(); i++)
+                context.outputStart[i + 1] = context.outputStart[i] + transactions[i].out.size();
+            context.layer.resize(context.outputStart.back());
+
+            if (parallel)
+            {
+                Failure failure;
+                for (size_t k = 0; k < graph.waveCount(); k++)
+                {
+                    const uint32_t *wave = graph.waveBegin(k);
+                    if (wave[0] >= failure.position())
+                        continue;
+                    pool.parallelFor(0, graph.waveSize(k), PARALLEL_GRAIN, [&](size_t begin, size_t end)
+                                     {
+                        for (size_t w = begin; w < end && wave[w] < failure.position(); w++)
+                        {
+                            Result result = checkTransaction(wave[w], context);
+                            if (!result.valid)
+                                failure.raise(result);
+                        } });
+                }
+                if (failure.position() != SIZE_MAX)
+                    return failure.take();
+            }
+            else
+            {
+                for (size_t i = 0; i < transactions.size(); i++)
+                {
+                    Result result = checkTransaction(i, context);
+                    if (!result.valid)
+                        return result;
+                }
+            }
+
+            const std::vector<SHAHash> &txids = context.txids;
+            std::string root = txids.empty() ? "" : MerkleTree(txids, pool).root().toString();
+            if (root != header.merkleRoot)
+                return Result{false, MERKLE_ROOT, 0, "Merkle root " + header.merkleRoot + " does not match transactions (" + root + ")"};
+
+            return Result();
+        }
+
+        static Result checkTransaction(size_t i, Context &context)
+        {
+            thread_local std::vector<uint8_t> buffer;
+            const Transaction &tx = context.transactions[i];
+            buffer.resize(tx.serializedSize());
+            tx.serialize(buffer.data());
+            SHAHash &txid = context.txids[i];
+            txid = sha256d(buffer.data(), buffer.size());
+            if (txid != tx.txid || !matchesHex(txid, tx.hash))
+                return Result{false, TRANSACTION_HASH, i, "Transaction hash does not match its contents"};
+
+            if (context.graph.position(tx.txIndex) != i)
+                return Result{false, INPUTS, i, "Duplicate txIndex " + std::to_string(tx.txIndex)};
+
+            std::string error = checkInputs(tx, i, context);
+            if (!error.empty())
+                return Result{false, INPUTS, i, error};
+
+            // UtxoSet::apply() would refuse these, so connect() must too
+            for (uint32_t n = 0; n < tx.out.size(); n++)
+            {
+                if (context.utxos.contains(OutPoint{tx.txIndex, n}))
+                    return Result{false, INPUTS, i, "Recreates unspent output " + std::to_string(tx.txIndex) + ":" + std::to_string(n)};
+            }
+
+            LayerOutput *created = context.layer.data() + context.outputStart[i];
+            for (const auto &output : tx.out)
+                *created++ = LayerOutput{output.value, &output.addr};
+            return Result();
+        }
+
+        static bool matchesHex(const SHAHash &digest, const std::string &hex)
+        {
+            char expected[SHAHash::HEX_LENGTH];
+            digest.toHex(expected);
+            return hex.size() == SHAHash::HEX_LENGTH && std::memcmp(expected, hex.data(), SHAHash::HEX_LENGTH) == 0;
+        }
+
+        // Empty on success. Reads `utxos` only, so chunks share it safely.
+        static std::string checkInputs(const Transaction &tx, size_t position, const Context &context)
+        {
+            double in = 0;
+            for (size_t k = 0; k < tx.inputs.size(); k++)
+            {
+                const PrevOut &prevOut = tx.inputs[k].prev_out;
+                std::string name = std::to_string(prevOut.txIndex) + ":" + std::to_string(prevOut.n);
+                if (context.spentBefore[context.inputStart[position] + k])
+                    return "Output " + name + " spent twice";
+
+                uint32_t local = context.graph.position(prevOut.txIndex);
+                if (local != TransactionGraph::NONE)
+                {
+                    if (local >= position)
+                        return "Spends output of a later transaction " + name;
+                    if (prevOut.n >= context.outputStart[local + 1] - context.outputStart[local])
+                        return "Spends an output that does not match " + name;
+                    // The parent is in an earlier wave and, being earlier in
+                    // the block, passed, or this check would not be running
+                    const LayerOutput &created = context.layer[context.outputStart[local] + prevOut.n];
+                    if (!created.addr)
+                        return "Spends an output that was not created " + name;
+                    if (created.value != prevOut.value || *created.addr != prevOut.addr)
+                        return "Spends an output that does not match " + name;
+                }
+                else
+                {
+                    Coin coin;
+                    if (!context.utxos.find(OutPoint::of(prevOut), coin))
+                        return "Spends a missing output " + name;
+                    if (coin.value != prevOut.value || context.utxos.address(coin.addr) != prevOut.addr)
+                        return "Spends an output that does not match " + name;
+                }
+                in += prevOut.value;
+            }
+
+            // Transactions without inputs create new coins
+            if (tx.inputs.empty() && position != 0 && !context.genesis)
+                return "Only the coinbase may have no inputs";
+            if (!tx.inputs.empty())
+            {
+                double out = 0;
+                for (const auto &output : tx.out)
+                    out += output.value;
+                if (out > in)
+                    return "Outputs exceed inputs";
+            }
+            return "";
+        }
+
+        // Flags every input after the first to spend a given outpoint
+        static void markDoubleSpends(Context &context)
+        {
+            const std::vector<Transaction> &transactions = context.transactions;
+            context.inputStart.resize(transactions.size() + 1, 0);
+            for (size_t i = 0; i < transactions.size(); i++)
+                context.inputStart[i + 1] = context.inputStart[i] + transactions[i].inputs.size();
+
+            std::vector<std::pair<OutPoint, size_t>> spends;
+            spends.reserve(context.inputStart.back());
+            for (const auto &tx : transactions)
+            {
+                for (const auto &input : tx.inputs)
+                    spends.emplace_back(OutPoint::of(input.prev_out), spends.size());
+            }
+
+            std::sort(spends.begin(), spends.end(), [](const std::pair<OutPoint, size_t> &a, const std::pair<OutPoint, size_t> &b)
+                      {
+                if (a.first.txIndex != b.first.txIndex)
+                    return a.first.txIndex < b.first.txIndex;
+                if (a.first.n != b.first.n)
+                    return a.first.n < b.first.n;
+                return a.second < b.second; });
+
+            context.spentBefore.assign(spends.size(), 0);
+            for (size_t i = 1; i < spends.size(); i++)
+            {
+                if (spends[i].first == spends[i - 1].first)
+                    context.spentBefore[spends[i].second] = 1;
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef BLOCKCHAIN_BLOCK_VIEW
+#define BLOCKCHAIN_BLOCK_VIEW
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "transactionView.hpp"
+#include "block.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * Zero-copy reader for a block in the wire format of Block::serialize(),
+     * e.g. straight out of a MappedFile. Construction checks the framing of
+     * every transaction once; transactions() then walks them lazily as
+     * TransactionViews into the same buffer.
+     */
+    class BlockView
+    {
+    public:
+        // The whole buffer must be exactly one block; throws
+        // std::invalid_argument otherwise
+        BlockView(const uint8_t *data, size_t size) : begin(data)
+        {
+            if (size < BlockHeader::SIZE)
+                throw std::invalid_argument("Truncated block header");
+
+            encoding::Reader reader(data + BlockHeader::SIZE, size - BlockHeader::SIZE);
+            transactionCount = reader.varint();
+            transactionsBegin = reader.position();
+            for (uint64_t i = 0; i < transactionCount; i++)
+                TransactionView::parse(reader);
+
+            if (reader.remaining() != 0)
+                throw std::invalid_argument("Trailing bytes after block");
+            end = reader.position();
+        }
+
+        // Raw 80-byte header and its fields
+        const uint8_t *headerBytes() const { return begin; }
+        SHAHash previousHash() const { return SHAHash(begin); }
+        SHAHash merkleRoot() const { return SHAHash(begin + 32); }
+        uint32_t timestamp() const { return uint32_t(readLE(begin + 64, 4)); }
+        int32_t difficulty() const { return int32_t(readLE(begin + 68, 4)); }
+        uint64_t nonce() const { return readLE(begin + BlockHeader::NONCE_OFFSET, 8); }
+        SHAHash hash() const { return tin::sha256d_80(begin); }
+
+        uint64_t size() const { return transactionCount; }
+        ViewRange<TransactionView> transactions() const
+        {
+            return ViewRange<TransactionView>(transactionsBegin, end, transactionCount);
+        }
+
+        const uint8_t *data() const { return begin; }
+        size_t byteSize() const { return end - begin; }
+
+        Block materialize() const
+        {
+            std::vector<Transaction> txs;
+            txs.reserve(transactionCount);
+            for (const auto &tx : transactions())
+                txs.push_back(tx.materialize());
+            return Block(BlockHeader::deserializeBinary(begin), txs);
+        }
+
+    private:
+        const uint8_t *begin;
+        const uint8_t *transactionsBegin;
+        const uint8_t *end;
+        uint64_t transactionCount;
+
+        static uint64_t readLE(const uint8_t *in, size_t bytes)
+        {
+            uint64_t value = 0;
+            for (size_t i = 0; i < bytes; i++)
+                value |= uint64_t(in[i]) << (i * 8);
+            return value;
+        }
+    };
+}
+
+#endif
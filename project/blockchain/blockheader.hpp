@@ -5,13 +5,35 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <array>
+#include <limits>
+#include <stdexcept>
 #include "sha.hpp"
+#include "target.hpp"
+#include "jsonWriter.hpp"
 
 namespace tin_blockchain
 {
+    /**
+     * The block hash is the double SHA256 of an 80-byte binary encoding:
+     *
+     *   [0, 32)   previousHash (raw digest bytes, all zero when empty)
+     *   [32, 64)  merkleRoot   (raw digest bytes, all zero when empty)
+     *   [64, 68)  timestamp    (uint32, little-endian)
+     *   [68, 72)  difficulty   (uint32, little-endian)
+     *   [72, 80)  nonce        (uint64, little-endian)
+     *
+     * Everything a miner varies sits in the last 16 bytes, so the first
+     * SHA256 block is compressed once per header and reused as a midstate.
+     */
     class BlockHeader
     {
     public:
+        static constexpr size_t SIZE = 80;
+        static constexpr size_t TAIL_OFFSET = 64;
+        static constexpr size_t TAIL_SIZE = SIZE - TAIL_OFFSET;
+        static constexpr size_t NONCE_OFFSET = 72;
+
         std::string hash;
         std::string previousHash;
         std::string merkleRoot;
@@ -29,30 +51,148 @@ namespace tin_blockchain
             this->hash = hash;
         }
 
-        std::string serialize() const
+        // Throws std::invalid_argument if a hash field is neither empty nor
+        // 64 hex characters, or std::out_of_range if the timestamp needs more
+        // than 32 bits
+        void serializeBinary(uint8_t *out) const
+        {
+            decodeHashField(previousHash, out);
+            decodeHashField(merkleRoot, out + 32);
+            serializeTail(out + TAIL_OFFSET);
+        }
+
+        std::array<uint8_t, SIZE> serializeBinary() const
+        {
+            std::array<uint8_t, SIZE> out;
+            serializeBinary(out.data());
+            return out;
+        }
+
+        // Inverse of serializeBinary(); also sets `hash`. An all-zero hash
+        // field decodes to the empty string, which is how serializeBinary()
+        // writes one.
+        static BlockHeader deserializeBinary(const uint8_t *in)
+        {
+            BlockHeader header(encodeHashField(in), encodeHashField(in + 32), readLE(in + 64, 4), int32_t(readLE(in + 68, 4)));
+            header.nonce = readLE(in + NONCE_OFFSET, 8);
+            header.setHash(SHAHash(tin::sha256d_80(in)).toString());
+            return header;
+        }
+
+        // SHA256 state after the first 64 bytes, for sha256d_80(midstate, tail)
+        tin::SHA256::State midstate() const
+        {
+            uint8_t block[TAIL_OFFSET];
+            decodeHashField(previousHash, block);
+            decodeHashField(merkleRoot, block + 32);
+
+            tin::SHA256 sha;
+            sha.update(block, sizeof(block));
+            return sha.checkpoint();
+        }
+
+        void serializeTail(uint8_t *tail) const
+        {
+            if (timestamp > std::numeric_limits<uint32_t>::max())
+            {
+                throw std::out_of_range("Block timestamp does not fit the 32-bit header field");
+            }
+            writeLE(tail, timestamp, 4);
+            writeLE(tail + 4, uint32_t(difficulty), 4);
+            setTailNonce(tail, nonce);
+        }
+
+        static void setTailNonce(uint8_t *tail, uint64_t nonce)
         {
-            std::ostringstream oss;
-            oss << previousHash << merkleRoot << timestamp << difficulty << nonce;
-            return oss.str();
+            writeLE(tail + NONCE_OFFSET - TAIL_OFFSET, nonce, 8);
+        }
+
+        SHAHash computeDigest() const
+        {
+            uint8_t header[SIZE];
+            serializeBinary(header);
+            return tin::sha256d_80(header);
         }
 
         std::string computeHash() const
         {
-            return sha256(sha256(serialize()));
+            return computeDigest().toString();
+        }
+
+        Target target() const
+        {
+            return Target::fromDifficulty(difficulty);
+        }
+
+        // True when the hash has at least `difficulty` leading zero hex digits
+        bool meetsDifficulty(const SHAHash &digest) const
+        {
+            return target().isMetBy(digest);
+        }
+
+        bool meetsDifficulty(const std::string &hash) const
+        {
+            SHAHash digest;
+            return SHAHash::fromHex(hash.data(), hash.size(), digest) && meetsDifficulty(digest);
+        }
+
+        template <typename Sink>
+        void writeJson(JsonWriter<Sink> &json) const
+        {
+            json.beginObject()
+                .field("hash", hash)
+                .field("previousHash", previousHash)
+                .field("merkleRoot", merkleRoot)
+                .field("timestamp", timestamp)
+                .field("difficulty", difficulty)
+                .field("nonce", nonce)
+                .endObject();
         }
 
         std::string toString() const
         {
-            std::ostringstream oss;
-            oss << "{"
-                << " \"hash\": \"" << hash << "\""
-                << ", \"previousHash\": \"" << previousHash << "\""
-                << ", \"merkleRoot\": \"" << merkleRoot << "\""
-                << ", \"timestamp\": " << timestamp
-                << ", \"difficulty\": " << difficulty
-                << ", \"nonce\": " << nonce
-                << "}";
-            return oss.str();
+            StringSink sink;
+            JsonWriter<StringSink> json(sink);
+            writeJson(json);
+            return sink.str;
+        }
+
+    private:
+        static void decodeHashField(const std::string &hex, uint8_t *out)
+        {
+            if (hex.empty())
+            {
+                std::memset(out, 0, SHAHash::LENGTH);
+                return;
+            }
+            if (!tin::Hex::decode(hex, out, SHAHash::LENGTH))
+            {
+                throw std::invalid_argument("Header hash field is not 64 hex characters: " + hex);
+            }
+        }
+
+        static std::string encodeHashField(const uint8_t *in)
+        {
+            SHAHash digest(in);
+            return digest.isZero() ? std::string() : digest.toString();
+        }
+
+        static uint64_t readLE(const uint8_t *in, size_t bytes)
+        {
+            uint64_t value = 0;
+            for (size_t i = 0; i < bytes; i++)
+            {
+                value |= uint64_t(in[i]) << (i * 8);
+            }
+            return value;
+        }
+
+        static void writeLE(uint8_t *out, uint64_t value, size_t bytes)
+        {
+            for (size_t i = 0; i < bytes; i++)
+            {
+                out[i] = uint8_t(value >> (i * 8));
+            }
         }
     };
 
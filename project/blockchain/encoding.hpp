@@ -0,0 +1,188 @@
+#ifndef BLOCKCHAIN_ENCODING
+#define BLOCKCHAIN_ENCODING
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+namespace tin_blockchain
+{
+    /**
+     * Primitives of the binary wire format. Unsigned integers are LEB128
+     * varints (7 bits per byte, low group first), signed ones are zigzag
+     * mapped first, doubles are their 8 IEEE-754 bytes little-endian and
+     * strings are a varint length followed by the raw bytes.
+     *
+     * Writer encodes into a buffer the caller sized with the *Size()
+     * helpers; Reader decodes in place and throws std::invalid_argument on
+     * truncated or malformed input.
+     */
+    namespace encoding
+    {
+        inline size_t varintSize(uint64_t value)
+        {
+            size_t size = 1;
+            while (value >= 0x80)
+            {
+                value >>= 7;
+                size++;
+            }
+            return size;
+        }
+
+        inline uint64_t zigzag(int64_t value)
+        {
+            return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+        }
+
+        inline int64_t unzigzag(uint64_t value)
+        {
+            return int64_t(value >> 1) ^ -int64_t(value & 1);
+        }
+
+        inline size_t stringSize(const std::string &value)
+        {
+            return varintSize(value.size()) + value.size();
+        }
+
+        // Decoded values for the narrower Transaction fields. A value that
+        // does not fit would re-encode to other bytes, and so another txid,
+        // so it throws std::invalid_argument instead of being truncated.
+        inline int intField(int64_t value, const char *field)
+        {
+            if (value < INT32_MIN || value > INT32_MAX)
+                throw std::invalid_argument(std::string(field) + " " + std::to_string(value) + " does not fit 32 bits");
+            return int(value);
+        }
+
+        inline unsigned int unsignedField(uint64_t value, const char *field)
+        {
+            if (value > UINT32_MAX)
+                throw std::invalid_argument(std::string(field) + " " + std::to_string(value) + " does not fit 32 bits");
+            return (unsigned int)value;
+        }
+
+        class Writer
+        {
+        public:
+            explicit Writer(uint8_t *out) : out(out) {}
+
+            uint8_t *position() const { return out; }
+
+            void varint(uint64_t value)
+            {
+                while (value >= 0x80)
+                {
+                    *out++ = uint8_t(value) | 0x80;
+                    value >>= 7;
+                }
+                *out++ = uint8_t(value);
+            }
+
+            void signedVarint(int64_t value)
+            {
+                varint(zigzag(value));
+            }
+
+            void float64(double value)
+            {
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                for (int i = 0; i < 8; i++)
+                {
+                    *out++ = uint8_t(bits >> (i * 8));
+                }
+            }
+
+            void bytes(const void *data, size_t size)
+            {
+                std::memcpy(out, data, size);
+                out += size;
+            }
+
+            void string(const std::string &value)
+            {
+                varint(value.size());
+                bytes(value.data(), value.size());
+            }
+
+        private:
+            uint8_t *out;
+        };
+
+        class Reader
+        {
+        public:
+            Reader(const uint8_t *data, size_t size) : cursor(data), end(data + size) {}
+
+            const uint8_t *position() const { return cursor; }
+            size_t remaining() const { return end - cursor; }
+
+            uint64_t varint()
+            {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    need(1);
+                    uint8_t byte = *cursor++;
+                    // Overlong or non-minimal encodings would give one value
+                    // two byte forms, and so two txids
+                    if ((shift == 63 && byte > 1) || (shift > 0 && byte == 0))
+                        break;
+                    value |= uint64_t(byte & 0x7f) << shift;
+                    if (!(byte & 0x80))
+                        return value;
+                }
+                throw std::invalid_argument("Varint is overlong or not minimally encoded");
+            }
+
+            int64_t signedVarint()
+            {
+                return unzigzag(varint());
+            }
+
+            double float64()
+            {
+                need(8);
+                uint64_t bits = 0;
+                for (int i = 0; i < 8; i++)
+                {
+                    bits |= uint64_t(cursor[i]) << (i * 8);
+                }
+                cursor += 8;
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                return value;
+            }
+
+            // Returns a pointer into the buffer; the bytes are not copied
+            const uint8_t *bytes(size_t size)
+            {
+                need(size);
+                const uint8_t *data = cursor;
+                cursor += size;
+                return data;
+            }
+
+            // Length-prefixed string as (pointer, length) into the buffer
+            const char *string(size_t &length)
+            {
+                length = varint();
+                return reinterpret_cast<const char *>(bytes(length));
+            }
+
+        private:
+            const uint8_t *cursor;
+            const uint8_t *end;
+
+            void need(size_t size) const
+            {
+                if (size_t(end - cursor) < size)
+                    throw std::invalid_argument("Truncated binary encoding");
+            }
+        };
+    }
+}
+
+#endif
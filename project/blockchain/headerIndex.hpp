@@ -0,0 +1,309 @@
+#ifndef BLOCKCHAIN_HEADER_INDEX
+#define BLOCKCHAIN_HEADER_INDEX
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "blockheader.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * Expected number of hashes behind a chain, as a 256-bit unsigned
+     * integer in little-endian 64-bit limbs. A header of difficulty d has
+     * target 2^(256 - 4d) - 1, so its work is 2^(4d); d is clamped to
+     * [0, 63] so the sum of any realistic chain fits.
+     */
+    struct ChainWork
+    {
+        std::array<uint64_t, 4> limbs{};
+
+        static ChainWork ofDifficulty(int difficulty)
+        {
+            unsigned bits = difficulty <= 0 ? 0 : 4 * unsigned(std::min(difficulty, 63));
+            ChainWork work;
+            work.limbs[bits / 64] = uint64_t(1) << (bits % 64);
+            return work;
+        }
+
+        ChainWork &operator+=(const ChainWork &other)
+        {
+            uint64_t carry = 0;
+            for (size_t i = 0; i < limbs.size(); i++)
+            {
+                uint64_t sum = limbs[i] + other.limbs[i];
+                uint64_t next = sum < limbs[i];
+                limbs[i] = sum + carry;
+                carry = next | (limbs[i] < sum);
+            }
+            return *this;
+        }
+
+        bool operator<(const ChainWork &other) const
+        {
+            for (size_t i = limbs.size(); i-- > 0;)
+            {
+                if (limbs[i] != other.limbs[i])
+                    return limbs[i] < other.limbs[i];
+            }
+            return false;
+        }
+
+        bool operator==(const ChainWork &other) const { return limbs == other.limbs; }
+        bool operator!=(const ChainWork &other) const { return !(*this == other); }
+
+        // Big-endian hex, 64 characters
+        std::string toString() const
+        {
+            uint8_t bytes[32];
+            for (size_t i = 0; i < 32; i++)
+                bytes[i] = uint8_t(limbs[3 - i / 8] >> (56 - 8 * (i % 8)));
+            return tin::Hex::encode(bytes, sizeof(bytes));
+        }
+    };
+
+    /**
+     * Every known header, as a tree rooted at the genesis header. Entries
+     * live in one vector and name each other by position; an open-addressing
+     * table of positions finds them by hash. Each entry is 80 bytes (hash,
+     * cumulative work, parent, skip, height) plus about 6 bytes of table, and
+     * nothing is allocated per header.
+     *
+     * The skip pointer of a header at height h points to its ancestor at
+     * skipHeight(h), chosen as in Bitcoin Core's CBlockIndex so that
+     * ancestor() reaches any height in O(log n) steps. The tip is the
+     * header with the most cumulative work; on a tie the first one seen
+     * keeps it.
+     */
+    class HeaderIndex
+    {
+    public:
+        static const uint32_t NONE = UINT32_MAX;
+
+        struct Entry
+        {
+            SHAHash hash;
+            ChainWork chainWork; // sum over this header and its ancestors
+            uint32_t parent;
+            uint32_t skip;
+            uint32_t height;
+        };
+
+        static constexpr size_t ENTRY_SIZE = 80;
+
+        HeaderIndex() : slots(MIN_CAPACITY, 0) {}
+
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+
+        const Entry &operator[](uint32_t i) const { return entries[i]; }
+
+        // Position of the header with `hash`, or NONE
+        uint32_t find(const SHAHash &hash) const
+        {
+            size_t mask = slots.size() - 1;
+            for (size_t i = slotOf(hash) & mask;; i = (i + 1) & mask)
+            {
+                if (slots[i] == 0)
+                    return NONE;
+                if (entries[slots[i] - 1].hash == hash)
+                    return slots[i] - 1;
+            }
+        }
+
+        bool contains(const SHAHash &hash) const { return find(hash) != NONE; }
+
+        // Adds a header whose parent is already known and returns its
+        // position; a header that is already known just returns its
+        // position. Only the first header may have an empty previousHash.
+        // Throws std::invalid_argument if the header misses its difficulty
+        // or its parent is unknown.
+        uint32_t add(const BlockHeader &header)
+        {
+            SHAHash hash = header.computeDigest();
+            uint32_t known = find(hash);
+            if (known != NONE)
+                return known;
+            if (!header.meetsDifficulty(hash))
+                throw std::invalid_argument("Header " + hash.toString() + " does not meet difficulty " + std::to_string(header.difficulty));
+
+            uint32_t parent = NONE;
+            if (!header.previousHash.empty())
+            {
+                parent = find(SHAHash::fromHex(header.previousHash));
+                if (parent == NONE)
+                    throw std::invalid_argument("Header " + hash.toString() + " has unknown parent " + header.previousHash);
+            }
+            else if (!entries.empty())
+            {
+                throw std::invalid_argument("Header " + hash.toString() + " is a second genesis header");
+            }
+            if (entries.size() >= NONE - 1)
+                throw std::length_error("Header index is full");
+
+            Entry entry;
+            entry.hash = hash;
+            entry.chainWork = ChainWork::ofDifficulty(header.difficulty);
+            entry.parent = parent;
+            entry.skip = NONE;
+            entry.height = 0;
+            if (parent != NONE)
+            {
+                entry.chainWork += entries[parent].chainWork;
+                entry.height = entries[parent].height + 1;
+                entry.skip = ancestor(parent, skipHeight(entry.height));
+            }
+
+            uint32_t position = uint32_t(entries.size());
+            entries.push_back(entry);
+            insertSlot(position);
+            if (bestTip == NONE || entries[bestTip].chainWork < entry.chainWork)
+                bestTip = position;
+            return position;
+        }
+
+        // The most-work header, or NONE when empty
+        uint32_t tip() const { return bestTip; }
+
+        // Ancestor of `i` at `height`, or NONE if `height` is above it
+        uint32_t ancestor(uint32_t i, uint32_t height) const
+        {
+            if (i == NONE || height > entries[i].height)
+                return NONE;
+
+            uint32_t walk = i;
+            uint32_t walkHeight = entries[i].height;
+            while (walkHeight > height)
+            {
+                // Take the skip unless it overshoots, or unless the parent's
+                // skip would land closer to `height` without overshooting
+                uint32_t skipTo = skipHeight(walkHeight);
+                uint32_t parentSkipTo = skipHeight(walkHeight - 1);
+                const Entry &entry = entries[walk];
+                if (entry.skip != NONE && (skipTo == height || (skipTo > height && !(parentSkipTo + 2 < skipTo && parentSkipTo >= height))))
+                {
+                    walk = entry.skip;
+                    walkHeight = skipTo;
+                }
+                else
+                {
+                    walk = entry.parent;
+                    walkHeight--;
+                }
+            }
+            return walk;
+        }
+
+        // The deepest header that both `a` and `b` descend from (or are)
+        uint32_t lastCommonAncestor(uint32_t a, uint32_t b) const
+        {
+            if (entries[a].height > entries[b].height)
+                a = ancestor(a, entries[b].height);
+            else if (entries[b].height > entries[a].height)
+                b = ancestor(b, entries[a].height);
+
+            while (a != b)
+            {
+                // Equal heights have equal skip heights. Different skip
+                // targets mean the branches split below them, so both can
+                // jump; the same target means the split is above it.
+                if (entries[a].skip != entries[b].skip)
+                {
+                    a = entries[a].skip;
+                    b = entries[b].skip;
+                }
+                else
+                {
+                    a = entries[a].parent;
+                    b = entries[b].parent;
+                }
+            }
+            return a;
+        }
+
+        // The header at `height` on the most-work chain, or NONE
+        uint32_t atHeight(uint32_t height) const { return ancestor(bestTip, height); }
+
+        bool onMainChain(uint32_t i) const { return atHeight(entries[i].height) == i; }
+
+        void reserve(size_t headers)
+        {
+            entries.reserve(headers);
+            size_t capacity = slots.size();
+            while (capacity * 3 < headers * 4)
+                capacity *= 2;
+            if (capacity != slots.size())
+                rehash(capacity);
+        }
+
+        size_t memoryUsage() const
+        {
+            return entries.capacity() * sizeof(Entry) + slots.capacity() * sizeof(uint32_t);
+        }
+
+        // Height of the skip target of a header at `height`: clears the
+        // lowest set bit, or for odd heights the lowest two, so most skips
+        // are short and a few reach far back
+        static uint32_t skipHeight(uint32_t height)
+        {
+            if (height < 2)
+                return 0;
+            return (height & 1) ? clearLowestBit(clearLowestBit(height - 1)) + 1 : clearLowestBit(height);
+        }
+
+    private:
+        static_assert(sizeof(Entry) == ENTRY_SIZE, "Entry must stay packed");
+
+        static constexpr size_t MIN_CAPACITY = 64;
+
+        std::vector<Entry> entries;
+        // position + 1, or 0 for an empty slot
+        std::vector<uint32_t> slots;
+        uint32_t bestTip = NONE;
+
+        static uint32_t clearLowestBit(uint32_t n) { return n & (n - 1); }
+
+        // Mined hashes lead with zeros, so key on the last 8 bytes
+        static size_t slotOf(const SHAHash &hash)
+        {
+            uint64_t word;
+            std::memcpy(&word, hash.data() + SHAHash::LENGTH - sizeof(word), sizeof(word));
+            return size_t(word);
+        }
+
+        void insertSlot(uint32_t position)
+        {
+            if (entries.size() * 4 > slots.size() * 3)
+            {
+                rehash(slots.size() * 2);
+                return;
+            }
+            place(slots, position);
+        }
+
+        void place(std::vector<uint32_t> &table, uint32_t position) const
+        {
+            size_t mask = table.size() - 1;
+            size_t i = slotOf(entries[position].hash) & mask;
+            while (table[i] != 0)
+                i = (i + 1) & mask;
+            table[i] = position + 1;
+        }
+
+        // Rebuilds the table over every entry, including one just appended
+        void rehash(size_t capacity)
+        {
+            std::vector<uint32_t> bigger(capacity, 0);
+            for (uint32_t position = 0; position < entries.size(); position++)
+                place(bigger, position);
+            slots.swap(bigger);
+        }
+    };
+}
+
+#endif
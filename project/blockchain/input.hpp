@@ -5,6 +5,8 @@
 #include <sstream>
 #include <iomanip>
 #include <vector>
+#include "encoding.hpp"
+#include "jsonWriter.hpp"
 
 /**
  * @todo complete all variable in PrevOut
@@ -20,25 +22,57 @@ namespace tin_blockchain
         double value;
         uint64_t txIndex;
         std::string addr;
+        // Position of the spent output in its transaction's `out`
+        uint32_t n;
 
-        PrevOut(double value, uint64_t txIndex, const std::string &addr)
-            : value(value), txIndex(txIndex), addr(addr) {}
+        PrevOut(double value, uint64_t txIndex, const std::string &addr, uint32_t n = 0)
+            : value(value), txIndex(txIndex), addr(addr), n(n) {}
+
+        template <typename Sink>
+        void writeJson(JsonWriter<Sink> &json) const
+        {
+            json.beginObject()
+                .field("value", value)
+                .field("txIndex", txIndex)
+                .field("n", n)
+                .field("addr", addr)
+                .endObject();
+        }
 
         std::string toString() const
         {
-            std::ostringstream oss;
-            oss << "{"
-                << ", \"value\": " << value
-                << ", \"txIndex\": " << txIndex
-                << ", \"addr\": " << std::quoted(addr) << "}";
-            return oss.str();
+            StringSink sink;
+            JsonWriter<StringSink> json(sink);
+            writeJson(json);
+            return sink.str;
+        }
+
+        // value (f64), txIndex (varint), n (varint), addr (string)
+        size_t serializedSize() const
+        {
+            return 8 + encoding::varintSize(txIndex) + encoding::varintSize(n) + encoding::stringSize(addr);
+        }
+
+        void serialize(encoding::Writer &writer) const
+        {
+            writer.float64(value);
+            writer.varint(txIndex);
+            writer.varint(n);
+            writer.string(addr);
         }
 
-        std::string serialize() const
+        static PrevOut deserialize(encoding::Reader &reader)
         {
-            std::ostringstream oss;
-            oss << std::hex << txIndex << std::setw(8) << std::setfill('0');
-            return oss.str();
+            double value = reader.float64();
+            uint64_t txIndex = reader.varint();
+            uint64_t n = reader.varint();
+            if (n > UINT32_MAX)
+            {
+                throw std::invalid_argument("Output index out of range");
+            }
+            size_t length;
+            const char *addr = reader.string(length);
+            return PrevOut(value, txIndex, std::string(addr, length), uint32_t(n));
         }
     };
 
@@ -50,20 +84,35 @@ namespace tin_blockchain
         Input(const PrevOut &prev_out)
             : prev_out(prev_out) {}
 
+        template <typename Sink>
+        void writeJson(JsonWriter<Sink> &json) const
+        {
+            json.beginObject().key("prev_out");
+            prev_out.writeJson(json);
+            json.endObject();
+        }
+
         std::string toString() const
         {
-            std::ostringstream oss;
-            oss << "{"
-                << "\"prev_out\": " << prev_out.toString()
-                << "}";
-            return oss.str();
+            StringSink sink;
+            JsonWriter<StringSink> json(sink);
+            writeJson(json);
+            return sink.str;
+        }
+
+        size_t serializedSize() const
+        {
+            return prev_out.serializedSize();
+        }
+
+        void serialize(encoding::Writer &writer) const
+        {
+            prev_out.serialize(writer);
         }
 
-        std::string serialize() const
+        static Input deserialize(encoding::Reader &reader)
         {
-            std::ostringstream oss;
-            oss << prev_out.serialize();
-            return oss.str();
+            return Input(PrevOut::deserialize(reader));
         }
     };
 }
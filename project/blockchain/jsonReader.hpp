@@ -0,0 +1,691 @@
+#ifndef BLOCKCHAIN_JSON_READER
+#define BLOCKCHAIN_JSON_READER
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <istream>
+#include <functional>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+
+#include "transaction.hpp"
+#include "mappedFile.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace tin_blockchain
+{
+    /**
+     * Stage one of JSON parsing: the offsets of every structural character
+     * ({ } [ ] : ,) outside strings and of every unescaped quote, in order.
+     *
+     * Input is classified 64 bytes at a time into bitmasks (SSE2 compares
+     * where available). Backslash runs decide which quotes are escaped,
+     * a prefix XOR of the quote mask marks the bytes inside strings, and the
+     * set bits of the final mask are appended as offsets. State carried from
+     * one block to the next is two bits, so the scan is branch-light and
+     * independent of nesting.
+     */
+    class JsonIndexer
+    {
+    public:
+        // Replaces `indexes` with the offsets for data[0, size).
+        // Returns false if the input ends inside a string.
+        static bool index(const char *data, size_t size, std::vector<uint32_t> &indexes)
+        {
+            if (size > UINT32_MAX)
+                throw std::invalid_argument("JSON document larger than 4 GiB");
+
+            indexes.clear();
+            uint64_t prevEscaped = 0;
+            uint64_t prevInString = 0;
+
+            for (size_t offset = 0; offset < size; offset += 64)
+            {
+                Masks masks;
+                if (size - offset >= 64)
+                {
+                    classify(data + offset, masks);
+                }
+                else
+                {
+                    char padded[64];
+                    std::memset(padded, ' ', sizeof(padded));
+                    std::memcpy(padded, data + offset, size - offset);
+                    classify(padded, masks);
+                }
+
+                uint64_t quotes = masks.quote & ~escapedBy(masks.backslash, prevEscaped);
+                uint64_t inString = prefixXor(quotes) ^ prevInString;
+                prevInString = uint64_t(int64_t(inString) >> 63);
+
+                uint64_t tokens = (masks.structural & ~inString) | quotes;
+                while (tokens)
+                {
+                    indexes.push_back(uint32_t(offset + __builtin_ctzll(tokens)));
+                    tokens &= tokens - 1;
+                }
+            }
+            return prevInString == 0;
+        }
+
+    private:
+        struct Masks
+        {
+            uint64_t quote;
+            uint64_t backslash;
+            uint64_t structural;
+        };
+
+        static void classify(const char *block, Masks &masks)
+        {
+#if defined(__SSE2__)
+            masks.quote = masks.backslash = masks.structural = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 16));
+                __m128i structural = _mm_or_si128(
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('{')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}'))),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('[')), _mm_cmpeq_epi8(v, _mm_set1_epi8(']')))),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+
+                masks.quote |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))))) << (i * 16);
+                masks.backslash |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))))) << (i * 16);
+                masks.structural |= uint64_t(uint16_t(_mm_movemask_epi8(structural))) << (i * 16);
+            }
+#else
+            masks.quote = masks.backslash = masks.structural = 0;
+            for (int i = 0; i < 64; i++)
+            {
+                char c = block[i];
+                uint64_t bit = uint64_t(1) << i;
+                if (c == '"')
+                    masks.quote |= bit;
+                else if (c == '\\')
+                    masks.backslash |= bit;
+                else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',')
+                    masks.structural |= bit;
+            }
+#endif
+        }
+
+        // Bits of characters escaped by a backslash. A run of backslashes
+        // escapes the character after it only if the run has odd length,
+        // which is found by adding the odd-position run starts to the mask
+        // and looking at where the carries land.
+        static uint64_t escapedBy(uint64_t backslash, uint64_t &prevEscaped)
+        {
+            const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+            backslash &= ~prevEscaped;
+            uint64_t followsEscape = (backslash << 1) | prevEscaped;
+            uint64_t oddStarts = backslash & ~EVEN_BITS & ~followsEscape;
+
+            uint64_t evenStartSequences;
+            prevEscaped = __builtin_add_overflow(oddStarts, backslash, &evenStartSequences);
+            uint64_t invertMask = evenStartSequences << 1;
+            return (EVEN_BITS ^ invertMask) & followsEscape;
+        }
+
+        // Bit i is the XOR of bits 0..i: set from an opening quote up to,
+        // not including, its closing quote
+        static uint64_t prefixXor(uint64_t bits)
+        {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+    };
+
+    /**
+     * Decodes transactions in the format of temp/transaction.json into
+     * tin_blockchain::Transaction. Stage two walks JsonIndexer's offsets:
+     * containers and strings are found directly from the index, scalars lie
+     * between a ':' or ',' and the next structural character. Unknown keys
+     * are skipped by jumping over their index range.
+     *
+     * Accepted documents: a transaction object, an array of them, or any
+     * whitespace-separated sequence of those (which covers NDJSON). The
+     * camelCase keys written by writeJson() are read as well. The index,
+     * string scratch space and stream buffer are kept between calls.
+     * All errors throw std::invalid_argument with the byte offset.
+     */
+    class TransactionJsonReader
+    {
+    public:
+        typedef std::function<void(Transaction &&)> Callback;
+
+        static constexpr size_t STREAM_CHUNK = 1 << 20;
+        static constexpr size_t MAX_DOCUMENT = 64 << 20;
+
+        // Parses a complete buffer; returns the number of transactions
+        size_t parse(const char *data, size_t size, const Callback &onTransaction)
+        {
+            if (!JsonIndexer::index(data, size, indexes))
+                throw std::invalid_argument("JSON ends inside a string");
+
+            Parser parser(data, size, indexes, scratch);
+            size_t count = 0;
+            parser.checkLeading();
+            while (!parser.atEnd())
+            {
+                char c = parser.peek();
+                if (c == '{')
+                {
+                    onTransaction(parser.transaction());
+                    count++;
+                }
+                else if (c == '[')
+                {
+                    count += parser.transactionArray(onTransaction);
+                }
+                else
+                {
+                    parser.fail("expected a transaction object or array");
+                }
+            }
+            return count;
+        }
+
+        std::vector<Transaction> parse(std::string_view json)
+        {
+            std::vector<Transaction> transactions;
+            parse(json.data(), json.size(), [&](Transaction &&tx)
+                  { transactions.push_back(std::move(tx)); });
+            return transactions;
+        }
+
+        // NDJSON only: every line must be a complete document. Input is read
+        // in STREAM_CHUNK pieces cut at newlines, so memory is bounded by
+        // the chunk size and the longest line (MAX_DOCUMENT), but a
+        // pretty-printed document spanning a cut fails. Use parseFile() or
+        // parse() for those.
+        size_t parseNdjson(std::istream &in, const Callback &onTransaction)
+        {
+            size_t count = 0;
+            size_t filled = 0;
+            streamBuffer.resize(STREAM_CHUNK);
+
+            while (true)
+            {
+                in.read(streamBuffer.data() + filled, streamBuffer.size() - filled);
+                filled += in.gcount();
+                bool eof = !in;
+
+                size_t end = filled;
+                if (!eof)
+                {
+                    while (end > 0 && streamBuffer[end - 1] != '\n')
+                        end--;
+                }
+
+                if (end == 0 && !eof)
+                {
+                    if (streamBuffer.size() >= MAX_DOCUMENT)
+                        throw std::invalid_argument("NDJSON line longer than MAX_DOCUMENT");
+                    streamBuffer.resize(std::min(streamBuffer.size() * 2, MAX_DOCUMENT));
+                    continue;
+                }
+
+                count += parse(streamBuffer.data(), end, onTransaction);
+
+                if (eof)
+                    break;
+
+                std::memmove(streamBuffer.data(), streamBuffer.data() + end, filled - end);
+                filled -= end;
+                if (streamBuffer.size() > STREAM_CHUNK && filled < STREAM_CHUNK / 2)
+                {
+                    streamBuffer.resize(STREAM_CHUNK);
+                    streamBuffer.shrink_to_fit();
+                }
+            }
+            return count;
+        }
+
+        // Maps the whole file and parses it as one buffer, so any accepted
+        // layout works: a pretty-printed array as well as NDJSON
+        size_t parseFile(const std::string &path, const Callback &onTransaction)
+        {
+            MappedFile file(path);
+            return parse(reinterpret_cast<const char *>(file.data()), file.size(), onTransaction);
+        }
+
+    private:
+        std::vector<uint32_t> indexes;
+        std::string scratch;
+        std::vector<char> streamBuffer;
+
+        class Parser
+        {
+        public:
+            Parser(const char *data, size_t size, const std::vector<uint32_t> &indexes, std::string &scratch)
+                : data(data), size(size), idx(indexes.data()), count(indexes.size()), scratch(scratch) {}
+
+            bool atEnd() const { return t >= count; }
+
+            char peek() const
+            {
+                if (t >= count)
+                    fail("unexpected end of input");
+                return data[idx[t]];
+            }
+
+            [[noreturn]] void fail(const std::string &what) const
+            {
+                size_t offset = t < count ? idx[t] : size;
+                throw std::invalid_argument("Invalid transaction JSON at offset " + std::to_string(offset) + ": " + what);
+            }
+
+            // Only whitespace may precede the first token; close() checks
+            // what follows each document
+            void checkLeading() const
+            {
+                if (!onlySpace(0, count > 0 ? idx[0] : size))
+                    fail("expected a transaction object or array");
+            }
+
+            size_t transactionArray(const Callback &onTransaction)
+            {
+                size_t n = 0;
+                array([&]()
+                      {
+                    if (peek() != '{')
+                        fail("expected a transaction object");
+                    onTransaction(transaction());
+                    n++; });
+                return n;
+            }
+
+            Transaction transaction()
+            {
+                int fee = 0, blockIndex = 0, blockHeight = 0;
+                unsigned int time = 0;
+                uint64_t txIndex = 0;
+                std::vector<Input> inputs;
+                std::vector<Output> out;
+
+                object([&](std::string_view key, size_t colon)
+                       {
+                    if (key == "fee")
+                        fee = int32(colon);
+                    else if (key == "tx_index" || key == "txIndex")
+                        txIndex = unsignedInteger(colon);
+                    else if (key == "time")
+                        time = uint32(colon);
+                    else if (key == "block_index" || key == "blockIndex")
+                        blockIndex = int32(colon);
+                    else if (key == "block_height" || key == "blockHeight")
+                        blockHeight = int32(colon);
+                    else if (key == "inputs")
+                        array([&]() { inputs.push_back(input()); });
+                    else if (key == "out")
+                        array([&]() { out.push_back(output()); });
+                    else
+                        skipValue(colon); });
+
+                return Transaction(fee, txIndex, time, blockIndex, blockHeight, inputs, out);
+            }
+
+        private:
+            const char *data;
+            size_t size;
+            const uint32_t *idx;
+            size_t count;
+            std::string &scratch;
+            size_t t = 0;
+
+            static bool isSpace(char c)
+            {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+            }
+
+            bool onlySpace(size_t begin, size_t end) const
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    if (!isSpace(data[i]))
+                        return false;
+                }
+                return true;
+            }
+
+            // Consumes a closing bracket or quote. Only whitespace may sit
+            // between it and the next token, since no scalar can follow one.
+            void close()
+            {
+                size_t end = idx[t++] + 1;
+                if (!onlySpace(end, t < count ? idx[t] : size))
+                    fail("unexpected characters");
+            }
+
+            void expect(char c)
+            {
+                if (peek() != c)
+                    fail(std::string("expected '") + c + "'");
+                t++;
+            }
+
+            // Calls onKey(key, offset of the ':') for each member; onKey must
+            // consume the value
+            template <typename OnKey>
+            void object(OnKey &&onKey)
+            {
+                size_t open = idx[t];
+                expect('{');
+                if (peek() == '}' && onlySpace(open + 1, idx[t]))
+                {
+                    close();
+                    return;
+                }
+                while (true)
+                {
+                    std::string_view key = string();
+                    size_t colon = idx[t];
+                    expect(':');
+                    onKey(key, colon);
+
+                    char c = peek();
+                    if (c == '}')
+                    {
+                        close();
+                        return;
+                    }
+                    if (c != ',')
+                        fail("expected ',' or '}'");
+                    t++;
+                }
+            }
+
+            // Calls onElement() for each element; it must consume the value
+            template <typename OnElement>
+            void array(OnElement &&onElement)
+            {
+                size_t open = idx[t];
+                expect('[');
+                if (peek() == ']' && onlySpace(open + 1, idx[t]))
+                {
+                    close();
+                    return;
+                }
+                while (true)
+                {
+                    onElement();
+                    char c = peek();
+                    if (c == ']')
+                    {
+                        close();
+                        return;
+                    }
+                    if (c != ',')
+                        fail("expected ',' or ']'");
+                    t++;
+                }
+            }
+
+            // Quotes are indexed in pairs, so the closing quote is the next
+            // offset. The view points into the input unless the string has
+            // escapes, in which case it is decoded into the scratch buffer
+            // (valid until the next escaped string).
+            std::string_view string()
+            {
+                if (peek() != '"' || t + 1 >= count)
+                    fail("expected a string");
+                const char *begin = data + idx[t] + 1;
+                const char *end = data + idx[t + 1];
+                t++;
+                close();
+
+                std::string_view raw(begin, end - begin);
+                if (raw.find('\\') == std::string_view::npos)
+                    return raw;
+                return unescape(raw);
+            }
+
+            std::string_view unescape(std::string_view raw)
+            {
+                scratch.clear();
+                for (size_t i = 0; i < raw.size(); i++)
+                {
+                    if (raw[i] != '\\')
+                    {
+                        scratch += raw[i];
+                        continue;
+                    }
+                    if (++i >= raw.size())
+                        fail("bad escape");
+                    switch (raw[i])
+                    {
+                    case 'n':
+                        scratch += '\n';
+                        break;
+                    case 't':
+                        scratch += '\t';
+                        break;
+                    case 'r':
+                        scratch += '\r';
+                        break;
+                    case 'b':
+                        scratch += '\b';
+                        break;
+                    case 'f':
+                        scratch += '\f';
+                        break;
+                    case 'u':
+                    {
+                        unsigned code = 0;
+                        if (i + 4 >= raw.size() || std::from_chars(raw.data() + i + 1, raw.data() + i + 5, code, 16).ptr != raw.data() + i + 5)
+                            fail("bad \\u escape");
+                        i += 4;
+                        // Basic multilingual plane as UTF-8; surrogate pairs are not
+                        // combined (addresses and scripts are ASCII)
+                        if (code < 0x80)
+                            scratch += char(code);
+                        else if (code < 0x800)
+                        {
+                            scratch += char(0xc0 | (code >> 6));
+                            scratch += char(0x80 | (code & 0x3f));
+                        }
+                        else
+                        {
+                            scratch += char(0xe0 | (code >> 12));
+                            scratch += char(0x80 | ((code >> 6) & 0x3f));
+                            scratch += char(0x80 | (code & 0x3f));
+                        }
+                        break;
+                    }
+                    default:
+                        scratch += raw[i];
+                    }
+                }
+                return scratch;
+            }
+
+            // A scalar starts after the preceding structural character and
+            // ends at the next indexed one
+            std::string_view scalar(size_t after)
+            {
+                size_t begin = after + 1;
+                size_t end = t < count ? idx[t] : size;
+                while (begin < end && isSpace(data[begin]))
+                    begin++;
+                while (end > begin && isSpace(data[end - 1]))
+                    end--;
+                if (begin == end || data[begin] == '"' || data[begin] == '{' || data[begin] == '[')
+                    fail("expected a number");
+                return std::string_view(data + begin, end - begin);
+            }
+
+            double number(size_t after)
+            {
+                std::string_view text = scalar(after);
+                double value;
+                auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+                if (result.ec != std::errc() || result.ptr != text.data() + text.size())
+                    fail("bad number");
+                return value;
+            }
+
+            int64_t integer(size_t after)
+            {
+                std::string_view text = scalar(after);
+                int64_t value;
+                auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+                if (result.ec == std::errc() && result.ptr == text.data() + text.size())
+                    return value;
+                return integral(number(after));
+            }
+
+            uint64_t unsignedInteger(size_t after)
+            {
+                std::string_view text = scalar(after);
+                uint64_t value;
+                auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+                if (result.ec == std::errc() && result.ptr == text.data() + text.size())
+                    return value;
+                double d = number(after);
+                if (d < 0)
+                    fail("expected a non-negative integer");
+                return uint64_t(integral(d));
+            }
+
+            // The 32-bit Transaction fields; out-of-range values fail rather
+            // than wrap into a different transaction
+            int int32(size_t after)
+            {
+                int64_t value = integer(after);
+                if (value < INT32_MIN || value > INT32_MAX)
+                    fail("integer out of 32-bit range");
+                return int(value);
+            }
+
+            unsigned int uint32(size_t after)
+            {
+                uint64_t value = unsignedInteger(after);
+                if (value > UINT32_MAX)
+                    fail("integer out of 32-bit range");
+                return (unsigned int)value;
+            }
+
+            // Accepts exponent forms such as 4.92e6 when they are whole numbers
+            int64_t integral(double value)
+            {
+                if (value != std::floor(value) || std::fabs(value) > 9.2e18)
+                    fail("expected an integer");
+                return int64_t(value);
+            }
+
+            // prev_out and out entries share value / tx_index / n / addr;
+            // an output's n is its position, so only PrevOut keeps it
+            struct OutputFields
+            {
+                double value = 0;
+                uint64_t txIndex = 0;
+                uint32_t n = 0;
+                std::string addr;
+            };
+
+            OutputFields outputFields()
+            {
+                OutputFields fields;
+                object([&](std::string_view key, size_t colon)
+                       {
+                    if (key == "value")
+                        fields.value = number(colon);
+                    else if (key == "tx_index" || key == "txIndex")
+                        fields.txIndex = unsignedInteger(colon);
+                    else if (key == "n")
+                    {
+                        uint64_t n = unsignedInteger(colon);
+                        if (n > UINT32_MAX)
+                            fail("output index out of range");
+                        fields.n = uint32_t(n);
+                    }
+                    else if (key == "addr")
+                    {
+                        if (peek() != '"')
+                            fail("expected a string");
+                        fields.addr = std::string(string());
+                    }
+                    else
+                        skipValue(colon); });
+                return fields;
+            }
+
+            Input input()
+            {
+                PrevOut prevOut(0, 0, "");
+                object([&](std::string_view key, size_t colon)
+                       {
+                    if (key == "prev_out")
+                    {
+                        OutputFields fields = outputFields();
+                        prevOut = PrevOut(fields.value, fields.txIndex, fields.addr, fields.n);
+                    }
+                    else
+                        skipValue(colon); });
+                return Input(prevOut);
+            }
+
+            Output output()
+            {
+                OutputFields fields = outputFields();
+                return Output(fields.value, fields.txIndex, fields.addr);
+            }
+
+            // Containers are skipped by bracket depth over the index;
+            // strings are two offsets; scalars are not in the index at all
+            void skipValue(size_t after)
+            {
+                char c = peek();
+                size_t begin = after + 1;
+                while (begin < size && isSpace(data[begin]))
+                    begin++;
+
+                if (begin != idx[t])
+                {
+                    scalar(after);
+                    return;
+                }
+                if (c == '"')
+                {
+                    string();
+                    return;
+                }
+                if (c != '{' && c != '[')
+                    fail("unexpected character");
+
+                size_t depth = 0;
+                while (true)
+                {
+                    char d = peek();
+                    if (d == '"')
+                    {
+                        t += 2;
+                        continue;
+                    }
+                    if (d == '{' || d == '[')
+                        depth++;
+                    else if ((d == '}' || d == ']') && --depth == 0)
+                    {
+                        close();
+                        return;
+                    }
+                    t++;
+                }
+            }
+        };
+    };
+}
+
+#endif
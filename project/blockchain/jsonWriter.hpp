@@ -0,0 +1,240 @@
+#ifndef BLOCKCHAIN_JSON_WRITER
+#define BLOCKCHAIN_JSON_WRITER
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace tin_blockchain
+{
+    /**
+     * Buffered sink over a file descriptor (file or socket). Bytes collect
+     * in a fixed buffer and go out in one write() whenever it fills, so
+     * memory use does not depend on how much is written. Throws
+     * std::runtime_error on I/O errors.
+     */
+    class FdSink
+    {
+    public:
+        static const size_t BUFFER_SIZE = 64 << 10;
+
+        // Borrows `fd`; the caller closes it
+        explicit FdSink(int fd) : fd(fd), owned(false) { buffer.reserve(BUFFER_SIZE); }
+
+        // Creates or truncates `path` and closes it on destruction
+        explicit FdSink(const std::string &path) : fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)), owned(true)
+        {
+            if (fd < 0)
+            {
+                throw std::runtime_error("Unable to open " + path + ": " + std::strerror(errno));
+            }
+            buffer.reserve(BUFFER_SIZE);
+        }
+
+        ~FdSink()
+        {
+            try
+            {
+                flush();
+            }
+            catch (...)
+            {
+            }
+            if (owned)
+                close(fd);
+        }
+
+        FdSink(const FdSink &) = delete;
+        FdSink &operator=(const FdSink &) = delete;
+
+        void write(const char *data, size_t size)
+        {
+            if (buffer.size() + size > BUFFER_SIZE)
+            {
+                flush();
+                if (size > BUFFER_SIZE)
+                {
+                    writeAll(data, size);
+                    return;
+                }
+            }
+            buffer.insert(buffer.end(), data, data + size);
+        }
+
+        void flush()
+        {
+            writeAll(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+    private:
+        int fd;
+        bool owned;
+        std::vector<char> buffer;
+
+        void writeAll(const char *data, size_t size)
+        {
+            while (size > 0)
+            {
+                ssize_t n = ::write(fd, data, size);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0)
+                    throw std::runtime_error(std::string("Unable to write JSON: ") + std::strerror(errno));
+                data += n;
+                size -= n;
+            }
+        }
+    };
+
+    // Sink that appends to a string, for toString()
+    class StringSink
+    {
+    public:
+        std::string str;
+
+        void write(const char *data, size_t size) { str.append(data, size); }
+        void flush() {}
+    };
+
+    /**
+     * Streaming JSON emitter. Values go straight to the sink: numbers via
+     * std::to_chars into a stack buffer, strings escaped as they are
+     * copied. Only the nesting state is kept, so nothing grows with the
+     * size of the document.
+     *
+     * Layout follows the existing toString() output: "key": value pairs
+     * separated by ", ".
+     */
+    template <typename Sink>
+    class JsonWriter
+    {
+    public:
+        explicit JsonWriter(Sink &sink) : sink(sink) {}
+
+        JsonWriter &beginObject() { return open('{'); }
+        JsonWriter &endObject() { return close('}'); }
+        JsonWriter &beginArray() { return open('['); }
+        JsonWriter &endArray() { return close(']'); }
+
+        JsonWriter &key(std::string_view name)
+        {
+            separate();
+            writeString(name);
+            sink.write(": ", 2);
+            afterKey = true;
+            return *this;
+        }
+
+        JsonWriter &value(std::string_view text)
+        {
+            separate();
+            writeString(text);
+            return *this;
+        }
+
+        JsonWriter &value(const char *text) { return value(std::string_view(text)); }
+        JsonWriter &value(const std::string &text) { return value(std::string_view(text)); }
+
+        JsonWriter &value(bool flag)
+        {
+            separate();
+            flag ? sink.write("true", 4) : sink.write("false", 5);
+            return *this;
+        }
+
+        template <typename Number>
+        typename std::enable_if<std::is_arithmetic<Number>::value && !std::is_same<Number, bool>::value, JsonWriter &>::type
+        value(Number number)
+        {
+            separate();
+            char digits[32];
+            auto end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+            sink.write(digits, end - digits);
+            return *this;
+        }
+
+        template <typename T>
+        JsonWriter &field(std::string_view name, const T &v)
+        {
+            return key(name).value(v);
+        }
+
+        void flush() { sink.flush(); }
+
+    private:
+        Sink &sink;
+        std::vector<bool> hasItems;
+        bool afterKey = false;
+
+        JsonWriter &open(char bracket)
+        {
+            separate();
+            sink.write(&bracket, 1);
+            hasItems.push_back(false);
+            return *this;
+        }
+
+        JsonWriter &close(char bracket)
+        {
+            hasItems.pop_back();
+            sink.write(&bracket, 1);
+            return *this;
+        }
+
+        // Comma before every item but the first in a container; nothing
+        // between a key and its value
+        void separate()
+        {
+            if (afterKey)
+            {
+                afterKey = false;
+                return;
+            }
+            if (!hasItems.empty())
+            {
+                if (hasItems.back())
+                    sink.write(", ", 2);
+                hasItems.back() = true;
+            }
+        }
+
+        void writeString(std::string_view text)
+        {
+            static const char HEX[] = "0123456789abcdef";
+            sink.write("\"", 1);
+
+            size_t run = 0;
+            for (size_t i = 0; i < text.size(); i++)
+            {
+                unsigned char c = text[i];
+                if (c >= 0x20 && c != '"' && c != '\\')
+                    continue;
+
+                sink.write(text.data() + run, i - run);
+                run = i + 1;
+                if (c == '"' || c == '\\')
+                {
+                    char escaped[2] = {'\\', char(c)};
+                    sink.write(escaped, 2);
+                }
+                else
+                {
+                    char escaped[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 15]};
+                    sink.write(escaped, 6);
+                }
+            }
+            sink.write(text.data() + run, text.size() - run);
+            sink.write("\"", 1);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef BLOCKCHAIN_MAPPED_FILE
+#define BLOCKCHAIN_MAPPED_FILE
+
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace tin_blockchain
+{
+    // Read-only memory map of a whole file, unmapped on destruction
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string &path)
+        {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Unable to open " + path + ": " + std::strerror(errno));
+            }
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                close(fd);
+                throw std::runtime_error("Unable to stat " + path + ": " + std::strerror(errno));
+            }
+
+            length = st.st_size;
+            if (length > 0)
+            {
+                void *map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (map == MAP_FAILED)
+                {
+                    close(fd);
+                    throw std::runtime_error("Unable to map " + path + ": " + std::strerror(errno));
+                }
+                bytes = static_cast<const uint8_t *>(map);
+            }
+            close(fd);
+        }
+
+        ~MappedFile()
+        {
+            if (bytes)
+                munmap(const_cast<uint8_t *>(bytes), length);
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        const uint8_t *data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        const uint8_t *bytes = nullptr;
+        size_t length = 0;
+    };
+
+    // Read-write shared map of a file that can only grow. Growing remaps,
+    // so pointers into data() are invalidated by reserve().
+    class MappedRegion
+    {
+    public:
+        // Opens or creates `path`, extending it to at least `minSize` bytes
+        MappedRegion(const std::string &path, size_t minSize) : path(path)
+        {
+            fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Unable to open " + path + ": " + std::strerror(errno));
+            }
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                close(fd);
+                throw std::runtime_error("Unable to stat " + path + ": " + std::strerror(errno));
+            }
+            created = st.st_size == 0;
+
+            try
+            {
+                map(std::max<size_t>(st.st_size, minSize));
+            }
+            catch (...)
+            {
+                close(fd);
+                throw;
+            }
+        }
+
+        ~MappedRegion()
+        {
+            if (bytes)
+                munmap(bytes, length);
+            close(fd);
+        }
+
+        MappedRegion(const MappedRegion &) = delete;
+        MappedRegion &operator=(const MappedRegion &) = delete;
+
+        uint8_t *data() { return bytes; }
+        const uint8_t *data() const { return bytes; }
+        size_t size() const { return length; }
+
+        // True if the file did not exist (or was empty) before opening
+        bool isNew() const { return created; }
+
+        // Grows to at least `size` bytes, at least doubling to keep remaps rare
+        void reserve(size_t size)
+        {
+            if (size <= length)
+                return;
+            munmap(bytes, length);
+            bytes = nullptr;
+            map(std::max(size, length * 2));
+        }
+
+        // Writes [offset, offset + size) back to the file and waits for it
+        void sync(size_t offset, size_t size)
+        {
+            static const size_t PAGE = sysconf(_SC_PAGESIZE);
+            size_t begin = offset / PAGE * PAGE;
+            size_t end = std::min(offset + size, length);
+            if (end > begin && msync(bytes + begin, end - begin, MS_SYNC) != 0)
+            {
+                throw std::runtime_error("Unable to sync " + path + ": " + std::strerror(errno));
+            }
+        }
+
+        void sync() { sync(0, length); }
+
+    private:
+        std::string path;
+        int fd = -1;
+        uint8_t *bytes = nullptr;
+        size_t length = 0;
+        bool created = false;
+
+        void map(size_t size)
+        {
+            if (ftruncate(fd, size) != 0)
+            {
+                throw std::runtime_error("Unable to resize " + path + ": " + std::strerror(errno));
+            }
+            void *region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (region == MAP_FAILED)
+            {
+                throw std::runtime_error("Unable to map " + path + ": " + std::strerror(errno));
+            }
+            bytes = static_cast<uint8_t *>(region);
+            length = size;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,401 @@
+#ifndef BLOCKCHAIN_MEMPOOL
+#define BLOCKCHAIN_MEMPOOL
+
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cstdint>
+
+#include "block.hpp"
+#include "utxoSet.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * Pending transactions, ordered by fee rate (fee / serialized size).
+     *
+     * A transaction's in-pool parents are the entries whose txIndex its
+     * inputs name. Every entry keeps running totals for its ancestor package
+     * (itself and all in-pool ancestors) and its descendant package, so the
+     * two ordered indexes stay current with O(log n) updates per affected
+     * entry:
+     *
+     *   ancestor score    package fee rate a miner gets by taking the entry
+     *                     with everything it needs; used for templates
+     *   descendant score  what the pool loses by dropping the entry and its
+     *                     dependants; the lowest is evicted first
+     *
+     * Inputs are not checked against the UTXO set here; a transaction that
+     * spends an outpoint already spent in the pool is a conflict and is
+     * refused. Parents must arrive before their children.
+     */
+    class Mempool
+    {
+    public:
+        struct Limits
+        {
+            size_t maxMemory = 300 << 20;
+            size_t maxAncestors = 25;
+            size_t maxDescendants = 25;
+        };
+
+        enum AddResult
+        {
+            ADDED,
+            DUPLICATE,
+            CONFLICT,
+            TOO_MANY_ANCESTORS,
+            TOO_MANY_DESCENDANTS,
+            OUT_OF_ORDER, // a pool transaction already spends one of its outputs
+            FEE_TOO_LOW   // added, then evicted to stay under maxMemory
+        };
+
+        struct Package
+        {
+            size_t count = 0;
+            uint64_t size = 0;
+            int64_t fee = 0;
+
+            double feeRate() const { return size == 0 ? 0 : double(fee) / size; }
+        };
+
+        struct Template
+        {
+            std::vector<Transaction> transactions; // parents before children
+            uint64_t size = 0;
+            int64_t fee = 0;
+        };
+
+        // Rough heap cost of one entry besides the transaction's own bytes
+        static const size_t ENTRY_OVERHEAD = 384;
+
+        Mempool() : Mempool(Limits()) {}
+        explicit Mempool(const Limits &limits) : limits(limits) {}
+
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+        size_t memoryUsage() const { return usage; }
+
+        bool contains(const SHAHash &txid) const { return byTxid.count(txid) > 0; }
+
+        const Transaction *get(const SHAHash &txid) const
+        {
+            auto it = byTxid.find(txid);
+            return it == byTxid.end() ? nullptr : &entries.at(it->second).tx;
+        }
+
+        Package ancestors(const SHAHash &txid) const { return entries.at(byTxid.at(txid)).ancestors; }
+        Package descendants(const SHAHash &txid) const { return entries.at(byTxid.at(txid)).descendants; }
+
+        AddResult add(const Transaction &tx)
+        {
+            if (byTxid.count(tx.txid) || byTxIndex.count(tx.txIndex))
+                return byTxid.count(tx.txid) ? DUPLICATE : CONFLICT;
+
+            std::vector<uint64_t> parents;
+            for (const auto &input : tx.inputs)
+            {
+                if (spentBy.count(OutPoint::of(input.prev_out)))
+                    return CONFLICT;
+                auto parent = byTxIndex.find(input.prev_out.txIndex);
+                if (parent != byTxIndex.end() && std::find(parents.begin(), parents.end(), parent->second) == parents.end())
+                    parents.push_back(parent->second);
+            }
+            for (uint32_t n = 0; n < tx.out.size(); n++)
+            {
+                if (spentBy.count(OutPoint{tx.txIndex, n}))
+                    return OUT_OF_ORDER;
+            }
+
+            std::vector<uint64_t> ancestorIds = closure(parents, &Entry::parents);
+            ancestorIds.insert(ancestorIds.end(), parents.begin(), parents.end());
+            if (ancestorIds.size() + 1 > limits.maxAncestors)
+                return TOO_MANY_ANCESTORS;
+            for (uint64_t a : ancestorIds)
+            {
+                if (entries.at(a).descendants.count + 1 > limits.maxDescendants)
+                    return TOO_MANY_DESCENDANTS;
+            }
+
+            uint64_t id = nextId++;
+            Entry &entry = entries.emplace(id, Entry(tx)).first->second;
+            entry.parents = parents;
+            entry.ancestors = entry.self();
+            entry.descendants = entry.self();
+            for (uint64_t a : ancestorIds)
+            {
+                Entry &ancestor = entries.at(a);
+                add(entry.ancestors, ancestor.self());
+                updateDescendants(a, entry.self(), +1);
+            }
+            for (uint64_t p : parents)
+                entries.at(p).children.push_back(id);
+
+            byTxid.emplace(tx.txid, id);
+            byTxIndex.emplace(tx.txIndex, id);
+            for (const auto &input : tx.inputs)
+                spentBy.emplace(OutPoint::of(input.prev_out), id);
+            byAncestorScore.insert(ancestorKey(id, entry));
+            byDescendantScore.insert(descendantKey(id, entry));
+            usage += entry.memory;
+
+            trim();
+            return byTxid.count(tx.txid) ? ADDED : FEE_TOO_LOW;
+        }
+
+        // Removes the transaction and everything that spends from it;
+        // returns how many entries went
+        size_t remove(const SHAHash &txid)
+        {
+            auto it = byTxid.find(txid);
+            return it == byTxid.end() ? 0 : removeWithDescendants(it->second);
+        }
+
+        // Drops what `block` confirmed, plus anything that conflicts with it
+        // and its descendants. Children of confirmed entries stay and simply
+        // lose those ancestors.
+        void removeForBlock(const Block &block)
+        {
+            for (const auto &tx : block.transactions)
+            {
+                auto it = byTxid.find(tx.txid);
+                if (it != byTxid.end())
+                {
+                    removeEntry(it->second);
+                    continue;
+                }
+                for (const auto &input : tx.inputs)
+                {
+                    auto spender = spentBy.find(OutPoint::of(input.prev_out));
+                    if (spender != spentBy.end())
+                        removeWithDescendants(spender->second);
+                }
+                auto sameIndex = byTxIndex.find(tx.txIndex);
+                if (sameIndex != byTxIndex.end())
+                    removeWithDescendants(sameIndex->second);
+            }
+        }
+
+        // One pass over the ancestor-score index, best first. Each candidate
+        // is taken with those of its ancestors not already in the template
+        // if the whole package fits in what is left of maxBytes. Scores are
+        // not recomputed as packages are taken.
+        Template selectTemplate(uint64_t maxBytes) const
+        {
+            Template result;
+            std::unordered_set<uint64_t> included;
+            std::vector<uint64_t> package;
+
+            for (const ScoreKey &key : byAncestorScore)
+            {
+                if (included.count(key.id))
+                    continue;
+
+                package = closure(std::vector<uint64_t>{key.id}, &Entry::parents, &included);
+                package.push_back(key.id);
+                uint64_t size = 0;
+                int64_t fee = 0;
+                for (uint64_t id : package)
+                {
+                    size += entries.at(id).size;
+                    fee += entries.at(id).tx.fee;
+                }
+                if (result.size + size > maxBytes)
+                    continue;
+
+                // Ids grow with arrival and parents arrive first
+                std::sort(package.begin(), package.end());
+                for (uint64_t id : package)
+                {
+                    included.insert(id);
+                    result.transactions.push_back(entries.at(id).tx);
+                }
+                result.size += size;
+                result.fee += fee;
+            }
+            return result;
+        }
+
+        // Fee rate of the package that would be evicted next
+        double minFeeRate() const
+        {
+            return byDescendantScore.empty() ? 0 : byDescendantScore.begin()->score;
+        }
+
+    private:
+        struct Entry
+        {
+            Transaction tx;
+            uint32_t size;
+            size_t memory;
+            std::vector<uint64_t> parents;
+            std::vector<uint64_t> children;
+            Package ancestors;
+            Package descendants;
+
+            explicit Entry(const Transaction &tx)
+                : tx(tx), size(uint32_t(tx.serializedSize())), memory(size + ENTRY_OVERHEAD + tx.hash.capacity()) {}
+
+            Package self() const
+            {
+                Package package;
+                package.count = 1;
+                package.size = size;
+                package.fee = tx.fee;
+                return package;
+            }
+        };
+
+        // Ordered by score, ties broken by age (older first)
+        struct ScoreKey
+        {
+            double score;
+            uint64_t id;
+
+            bool operator<(const ScoreKey &other) const
+            {
+                return score != other.score ? score < other.score : id < other.id;
+            }
+        };
+
+        struct BestFirst
+        {
+            bool operator()(const ScoreKey &a, const ScoreKey &b) const
+            {
+                return a.score != b.score ? a.score > b.score : a.id < b.id;
+            }
+        };
+
+        struct OutPointHash
+        {
+            size_t operator()(const OutPoint &outPoint) const
+            {
+                uint64_t h = outPoint.txIndex * 0x9e3779b97f4a7c15ULL ^ (uint64_t(outPoint.n) * 0xc2b2ae3d27d4eb4fULL);
+                return size_t(h ^ (h >> 32));
+            }
+        };
+
+        Limits limits;
+        std::unordered_map<uint64_t, Entry> entries;
+        std::unordered_map<SHAHash, uint64_t> byTxid;
+        std::unordered_map<uint64_t, uint64_t> byTxIndex;
+        std::unordered_map<OutPoint, uint64_t, OutPointHash> spentBy;
+        // Best package first for mining; cheapest package first for eviction
+        std::set<ScoreKey, BestFirst> byAncestorScore;
+        std::set<ScoreKey> byDescendantScore;
+        uint64_t nextId = 0;
+        size_t usage = 0;
+
+        static void add(Package &package, const Package &delta, int sign = +1)
+        {
+            if (sign > 0)
+            {
+                package.count += delta.count;
+                package.size += delta.size;
+                package.fee += delta.fee;
+            }
+            else
+            {
+                package.count -= delta.count;
+                package.size -= delta.size;
+                package.fee -= delta.fee;
+            }
+        }
+
+        static ScoreKey ancestorKey(uint64_t id, const Entry &entry) { return ScoreKey{entry.ancestors.feeRate(), id}; }
+        static ScoreKey descendantKey(uint64_t id, const Entry &entry) { return ScoreKey{entry.descendants.feeRate(), id}; }
+
+        // Every entry reachable from `start` through `links`, excluding the
+        // start entries themselves and anything in `stop`
+        std::vector<uint64_t> closure(const std::vector<uint64_t> &start, std::vector<uint64_t> Entry::*links,
+                                      const std::unordered_set<uint64_t> *stop = nullptr) const
+        {
+            std::vector<uint64_t> found;
+            std::unordered_set<uint64_t> seen(start.begin(), start.end());
+            std::vector<uint64_t> pending(start.begin(), start.end());
+            while (!pending.empty())
+            {
+                uint64_t id = pending.back();
+                pending.pop_back();
+                for (uint64_t next : entries.at(id).*links)
+                {
+                    if ((stop && stop->count(next)) || !seen.insert(next).second)
+                        continue;
+                    found.push_back(next);
+                    pending.push_back(next);
+                }
+            }
+            return found;
+        }
+
+        void updateDescendants(uint64_t id, const Package &delta, int sign)
+        {
+            Entry &entry = entries.at(id);
+            byDescendantScore.erase(descendantKey(id, entry));
+            add(entry.descendants, delta, sign);
+            byDescendantScore.insert(descendantKey(id, entry));
+        }
+
+        void updateAncestors(uint64_t id, const Package &delta, int sign)
+        {
+            Entry &entry = entries.at(id);
+            byAncestorScore.erase(ancestorKey(id, entry));
+            add(entry.ancestors, delta, sign);
+            byAncestorScore.insert(ancestorKey(id, entry));
+        }
+
+        // Unlinks one entry, taking it out of every relative's package totals
+        void removeEntry(uint64_t id)
+        {
+            Entry &entry = entries.at(id);
+            Package self = entry.self();
+
+            std::vector<uint64_t> start{id};
+            for (uint64_t a : closure(start, &Entry::parents))
+                updateDescendants(a, self, -1);
+            for (uint64_t d : closure(start, &Entry::children))
+                updateAncestors(d, self, -1);
+
+            for (uint64_t p : entry.parents)
+            {
+                auto &siblings = entries.at(p).children;
+                siblings.erase(std::find(siblings.begin(), siblings.end(), id));
+            }
+            for (uint64_t c : entry.children)
+            {
+                auto &parents = entries.at(c).parents;
+                parents.erase(std::find(parents.begin(), parents.end(), id));
+            }
+
+            byAncestorScore.erase(ancestorKey(id, entry));
+            byDescendantScore.erase(descendantKey(id, entry));
+            byTxid.erase(entry.tx.txid);
+            byTxIndex.erase(entry.tx.txIndex);
+            for (const auto &input : entry.tx.inputs)
+                spentBy.erase(OutPoint::of(input.prev_out));
+            usage -= entry.memory;
+            entries.erase(id);
+        }
+
+        size_t removeWithDescendants(uint64_t id)
+        {
+            std::vector<uint64_t> doomed = closure(std::vector<uint64_t>{id}, &Entry::children);
+            doomed.push_back(id);
+            // Children before parents, so every removal sees a consistent graph
+            std::sort(doomed.rbegin(), doomed.rend());
+            for (uint64_t d : doomed)
+                removeEntry(d);
+            return doomed.size();
+        }
+
+        void trim()
+        {
+            while (usage > limits.maxMemory && !byDescendantScore.empty())
+                removeWithDescendants(byDescendantScore.begin()->id);
+        }
+    };
+}
+
+#endif
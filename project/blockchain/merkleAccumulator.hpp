@@ -0,0 +1,88 @@
+#ifndef BLOCKCHAIN_MERKLE_ACCUMULATOR
+#define BLOCKCHAIN_MERKLE_ACCUMULATOR
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+#include "merkleTree.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * Append-only Merkle root for a block template that grows one
+     * transaction at a time. Only the right edge of the tree is kept:
+     * frontier[l] is the root of a complete subtree of 2^l leaves still
+     * waiting for its right sibling, present exactly when bit l of the leaf
+     * count is set.
+     *
+     * append() merges like a binary counter increment and root() folds the
+     * frontier, duplicating lone nodes the way MerkleTree does, so both are
+     * O(log n) and root() always equals MerkleTree(leaves).root().
+     */
+    class MerkleAccumulator
+    {
+    public:
+        static const size_t MAX_LEVELS = 64;
+
+        void append(const SHAHash &leaf)
+        {
+            SHAHash hash = leaf;
+            size_t level = 0;
+            for (; count & (uint64_t(1) << level); level++)
+            {
+                hash = MerkleTree::hashPair(frontier[level], hash);
+            }
+            frontier[level] = hash;
+            count++;
+        }
+
+        void append(const Transaction &tx)
+        {
+            append(SHAHash::fromHex(tx.hash));
+        }
+
+        uint64_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        void clear()
+        {
+            count = 0;
+        }
+
+        // Throws std::logic_error when nothing has been appended
+        SHAHash root() const
+        {
+            if (count == 0)
+                throw std::logic_error("Empty Merkle accumulator has no root");
+
+            // Start from the lowest pending subtree; every time it is alone on
+            // its level it is paired with itself, and the carry then absorbs
+            // the complete subtrees to its left.
+            size_t level = 0;
+            while (!(count & (uint64_t(1) << level)))
+                level++;
+
+            SHAHash hash = frontier[level];
+            uint64_t remaining = count;
+            while (remaining != (uint64_t(1) << level))
+            {
+                hash = MerkleTree::hashPair(hash, hash);
+                remaining += uint64_t(1) << level;
+                level++;
+                while (!(remaining & (uint64_t(1) << level)))
+                {
+                    hash = MerkleTree::hashPair(frontier[level], hash);
+                    level++;
+                }
+            }
+            return hash;
+        }
+
+    private:
+        std::array<SHAHash, MAX_LEVELS> frontier;
+        uint64_t count = 0;
+    };
+}
+
+#endif
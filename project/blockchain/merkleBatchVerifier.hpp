@@ -0,0 +1,123 @@
+#ifndef BLOCKCHAIN_MERKLE_BATCH_VERIFIER
+#define BLOCKCHAIN_MERKLE_BATCH_VERIFIER
+
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+
+#include "merkleTree.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * Verifies many Merkle inclusion proofs at once, e.g. for light clients.
+     *
+     * Proofs are sorted by (root, leaf index) and cut into runs of
+     * PARALLEL_GRAIN that run on the thread pool. Neighbouring leaves of one
+     * tree share most of their path, so each run memoizes parent hashes
+     * keyed by the two children and computes every shared node once. The
+     * memo is keyed on content, so each answer is exactly what
+     * MerkleTree::verify gives for that proof alone.
+     */
+    class MerkleBatchVerifier
+    {
+    public:
+        static const size_t PARALLEL_GRAIN = 256;
+
+        struct Item
+        {
+            SHAHash txid;
+            MerkleProof proof;
+            SHAHash merkleRoot;
+        };
+
+        struct Result
+        {
+            std::vector<uint8_t> valid; // one flag per item, in input order
+            size_t validCount = 0;
+            uint64_t hashesComputed = 0;
+            uint64_t hashesShared = 0;
+            double seconds = 0;
+
+            double proofsPerSecond() const { return seconds > 0 ? valid.size() / seconds : 0; }
+        };
+
+        static Result verify(const std::vector<Item> &items, tin::ThreadPool &pool = tin::ThreadPool::shared())
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            Result result;
+            result.valid.assign(items.size(), 0);
+
+            std::vector<size_t> order(items.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                      {
+                if (items[a].merkleRoot != items[b].merkleRoot)
+                    return items[a].merkleRoot < items[b].merkleRoot;
+                return items[a].proof.index < items[b].proof.index; });
+
+            std::atomic<uint64_t> computed(0);
+            std::atomic<uint64_t> shared(0);
+
+            pool.parallelFor(0, order.size(), PARALLEL_GRAIN, [&](size_t begin, size_t end)
+                             {
+                std::unordered_map<PairKey, SHAHash, PairKeyHash> memo;
+                uint64_t localComputed = 0;
+                uint64_t localShared = 0;
+
+                auto hashPair = [&](const SHAHash &left, const SHAHash &right)
+                {
+                    auto inserted = memo.emplace(PairKey{left, right}, SHAHash());
+                    if (inserted.second)
+                    {
+                        inserted.first->second = MerkleTree::hashPair(left, right);
+                        localComputed++;
+                    }
+                    else
+                    {
+                        localShared++;
+                    }
+                    return inserted.first->second;
+                };
+
+                for (size_t i = begin; i < end; i++)
+                {
+                    const Item &item = items[order[i]];
+                    result.valid[order[i]] = MerkleTree::verify(item.txid, item.proof, item.merkleRoot, hashPair);
+                }
+
+                computed += localComputed;
+                shared += localShared; });
+
+            result.validCount = std::count(result.valid.begin(), result.valid.end(), 1);
+            result.hashesComputed = computed;
+            result.hashesShared = shared;
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return result;
+        }
+
+    private:
+        struct PairKey
+        {
+            SHAHash left;
+            SHAHash right;
+
+            bool operator==(const PairKey &other) const { return left == other.left && right == other.right; }
+        };
+
+        struct PairKeyHash
+        {
+            size_t operator()(const PairKey &key) const
+            {
+                return SHAHash::Hash()(key.left) * 31 + SHAHash::Hash()(key.right);
+            }
+        };
+    };
+}
+
+#endif
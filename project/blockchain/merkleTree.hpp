@@ -4,43 +4,258 @@
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <stdexcept>
 
 #include "sha.hpp"
 #include "transaction.hpp"
+#include "../../global/concurrency/ThreadPool/ThreadPool.hpp"
 
 namespace tin_blockchain
 {
+    // Sibling hashes from a leaf up to (not including) the root
+    struct MerkleProof
+    {
+        // Wire layout: index (u64 LE), leafCount (u64 LE), sibling count (u8),
+        // then 32 bytes per sibling
+        static const size_t HEADER_SIZE = 17;
+
+        uint64_t index = 0;
+        uint64_t leafCount = 0;
+        std::vector<SHAHash> siblings;
+
+        size_t serializedSize() const
+        {
+            return HEADER_SIZE + siblings.size() * SHAHash::LENGTH;
+        }
+
+        void serialize(uint8_t *out) const
+        {
+            for (size_t i = 0; i < 8; i++)
+            {
+                out[i] = uint8_t(index >> (i * 8));
+                out[8 + i] = uint8_t(leafCount >> (i * 8));
+            }
+            out[16] = uint8_t(siblings.size());
+            for (size_t i = 0; i < siblings.size(); i++)
+            {
+                std::memcpy(out + HEADER_SIZE + i * SHAHash::LENGTH, siblings[i].data(), SHAHash::LENGTH);
+            }
+        }
+
+        std::vector<uint8_t> serialize() const
+        {
+            std::vector<uint8_t> out(serializedSize());
+            serialize(out.data());
+            return out;
+        }
+
+        // Throws std::invalid_argument if `size` does not match the encoded proof
+        static MerkleProof deserialize(const uint8_t *data, size_t size)
+        {
+            if (size < HEADER_SIZE || size != HEADER_SIZE + size_t(data[16]) * SHAHash::LENGTH)
+            {
+                throw std::invalid_argument("Malformed Merkle proof");
+            }
+
+            MerkleProof proof;
+            for (size_t i = 0; i < 8; i++)
+            {
+                proof.index |= uint64_t(data[i]) << (i * 8);
+                proof.leafCount |= uint64_t(data[8 + i]) << (i * 8);
+            }
+            proof.siblings.resize(data[16]);
+            for (size_t i = 0; i < proof.siblings.size(); i++)
+            {
+                proof.siblings[i] = SHAHash(data + HEADER_SIZE + i * SHAHash::LENGTH);
+            }
+            return proof;
+        }
 
+        static MerkleProof deserialize(const std::vector<uint8_t> &bytes)
+        {
+            return deserialize(bytes.data(), bytes.size());
+        }
+    };
+
+    /**
+     * Binary Merkle tree over 32-byte digests. A parent is the SHA256 of its
+     * two children's raw bytes; a level with an odd number of nodes pairs
+     * its last node with itself.
+     *
+     * Every level is kept, bottom up, in one contiguous buffer so proofs are
+     * read straight out of it. Levels are hashed with SHA256::hashMany, split
+     * across the thread pool once they are larger than PARALLEL_GRAIN pairs.
+     */
     class MerkleTree
     {
     public:
+        static const size_t PARALLEL_GRAIN = 2048;
+
+        MerkleTree() {}
+
+        explicit MerkleTree(const std::vector<SHAHash> &leaves, tin::ThreadPool &pool = tin::ThreadPool::shared())
+        {
+            build(leaves, pool);
+        }
+
+        static MerkleTree fromTransactions(const std::vector<Transaction> &transactions, tin::ThreadPool &pool = tin::ThreadPool::shared())
+        {
+            std::vector<SHAHash> leaves;
+            leaves.reserve(transactions.size());
+            for (const auto &tx : transactions)
+            {
+                leaves.push_back(SHAHash::fromHex(tx.hash));
+            }
+            return MerkleTree(leaves, pool);
+        }
+
+        bool empty() const { return levelSizes.empty(); }
+        size_t leafCount() const { return empty() ? 0 : levelSizes[0]; }
+        size_t levelCount() const { return levelSizes.size(); }
+        size_t levelSize(size_t level) const { return levelSizes.at(level); }
+
+        const SHAHash &node(size_t level, size_t index) const
+        {
+            if (index >= levelSize(level))
+                throw std::out_of_range("Merkle node index out of range");
+            return nodes[levelOffsets[level] + index];
+        }
+
+        // Throws std::logic_error for an empty tree
+        const SHAHash &root() const
+        {
+            if (empty())
+                throw std::logic_error("Empty Merkle tree has no root");
+            return nodes.back();
+        }
+
+        MerkleProof proof(size_t index) const
+        {
+            if (index >= leafCount())
+                throw std::out_of_range("Merkle proof index out of range");
+
+            MerkleProof proof;
+            proof.index = index;
+            proof.leafCount = leafCount();
+            proof.siblings.reserve(levelCount() - 1);
+
+            for (size_t level = 0; level + 1 < levelCount(); level++, index >>= 1)
+            {
+                size_t sibling = index ^ 1;
+                proof.siblings.push_back(node(level, sibling < levelSize(level) ? sibling : index));
+            }
+            return proof;
+        }
+
+        static SHAHash hashPair(const SHAHash &left, const SHAHash &right)
+        {
+            tin::SHA256 sha;
+            sha.update(left.data(), left.size()).update(right.data(), right.size());
+            return sha.digest();
+        }
+
+        // Walks a proof from `leaf` upwards and checks the implied root. A node
+        // that is last on an odd-sized level must be paired with itself, so a
+        // proof cannot claim a position past the real leaves.
+        template <typename HashPair>
+        static bool verify(const SHAHash &leaf, const MerkleProof &proof, const SHAHash &root, HashPair &&hashPair)
+        {
+            if (proof.index >= proof.leafCount || proof.siblings.size() != proofLength(proof.leafCount))
+                return false;
+
+            SHAHash hash = leaf;
+            uint64_t index = proof.index;
+            uint64_t size = proof.leafCount;
+            for (const auto &sibling : proof.siblings)
+            {
+                if ((index ^ 1) >= size && sibling != hash)
+                    return false;
+                hash = (index & 1) ? hashPair(sibling, hash) : hashPair(hash, sibling);
+                index >>= 1;
+                size = (size + 1) / 2;
+            }
+            return hash == root;
+        }
+
+        static bool verify(const SHAHash &leaf, const MerkleProof &proof, const SHAHash &root)
+        {
+            return verify(leaf, proof, root, &MerkleTree::hashPair);
+        }
+
+        // Number of siblings in a proof for a tree of `leaves` leaves
+        static size_t proofLength(uint64_t leaves)
+        {
+            size_t length = 0;
+            for (; leaves > 1; leaves = (leaves + 1) / 2)
+                length++;
+            return length;
+        }
+
         static std::string computeMerkleRoot(const std::vector<Transaction> &transactions)
         {
             if (transactions.empty())
                 return "";
+            return fromTransactions(transactions).root().toString();
+        }
 
-            std::vector<std::string> merkleLeaves;
-            for (const auto &tx : transactions)
+    private:
+        std::vector<SHAHash> nodes;
+        std::vector<size_t> levelOffsets;
+        std::vector<size_t> levelSizes;
+
+        void build(const std::vector<SHAHash> &leaves, tin::ThreadPool &pool)
+        {
+            static_assert(sizeof(SHAHash) == SHAHash::LENGTH, "digests must pack contiguously");
+            if (leaves.empty())
+                return;
+
+            size_t total = 0;
+            for (size_t size = leaves.size();; size = (size + 1) / 2)
+            {
+                levelOffsets.push_back(total);
+                levelSizes.push_back(size);
+                total += size;
+                if (size == 1)
+                    break;
+            }
+
+            nodes.resize(total);
+            std::copy(leaves.begin(), leaves.end(), nodes.begin());
+
+            for (size_t level = 0; level + 1 < levelSizes.size(); level++)
             {
-                merkleLeaves.push_back(tx.hash);
+                const SHAHash *children = nodes.data() + levelOffsets[level];
+                SHAHash *parents = nodes.data() + levelOffsets[level + 1];
+                size_t childCount = levelSizes[level];
+
+                pool.parallelFor(0, levelSizes[level + 1], PARALLEL_GRAIN, [&](size_t begin, size_t end)
+                                 { hashLevel(children, childCount, parents, begin, end); });
             }
+        }
 
-            while (merkleLeaves.size() > 1)
+        // Parents [begin, end) of one level; pairs are adjacent in the
+        // buffer, except the duplicated last node of an odd level
+        static void hashLevel(const SHAHash *children, size_t childCount, SHAHash *parents, size_t begin, size_t end)
+        {
+            uint8_t oddPair[2 * SHAHash::LENGTH];
+            std::vector<tin::ByteView> pairs;
+            pairs.reserve(end - begin);
+
+            for (size_t i = begin; i < end; i++)
             {
-                if (merkleLeaves.size() % 2 != 0)
+                if (2 * i + 1 < childCount)
                 {
-                    merkleLeaves.push_back(merkleLeaves.back());
+                    pairs.emplace_back(children[2 * i].data(), 2 * SHAHash::LENGTH);
                 }
-
-                std::vector<std::string> newLevel;
-                for (size_t i = 0; i < merkleLeaves.size(); i += 2)
+                else
                 {
-                    newLevel.push_back(sha256(merkleLeaves[i] + merkleLeaves[i + 1]));
+                    std::memcpy(oddPair, children[2 * i].data(), SHAHash::LENGTH);
+                    std::memcpy(oddPair + SHAHash::LENGTH, children[2 * i].data(), SHAHash::LENGTH);
+                    pairs.emplace_back(oddPair, sizeof(oddPair));
                 }
-                merkleLeaves = newLevel;
             }
 
-            return merkleLeaves[0];
+            tin::SHA256::hashMany(pairs.data(), reinterpret_cast<std::array<uint8_t, SHAHash::LENGTH> *>(parents + begin), pairs.size());
         }
     };
 }
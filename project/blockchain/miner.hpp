@@ -0,0 +1,165 @@
+#ifndef BLOCKCHAIN_MINER
+#define BLOCKCHAIN_MINER
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include "blockheader.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * Multi-threaded proof-of-work search. The nonce space is cut into
+     * ranges of `rangeSize` that threads claim in increasing order. A thread
+     * that finds a solution publishes it as the best nonce; others finish
+     * any range that starts below it and then stop. Every nonce below the
+     * winner is therefore tried, so the result is the lowest valid nonce,
+     * the same one the sequential Block::mine() finds.
+     */
+    class Miner
+    {
+    public:
+        struct Options
+        {
+            size_t threads = std::max(1u, std::thread::hardware_concurrency());
+            uint64_t startNonce = 0;
+            uint64_t endNonce = std::numeric_limits<uint64_t>::max(); // exclusive
+            uint64_t rangeSize = 1 << 12;
+            // Set from outside (e.g. when a competing block arrives) to abandon the search
+            const std::atomic<bool> *cancel = nullptr;
+        };
+
+        struct ThreadStats
+        {
+            uint64_t hashes = 0;
+            double seconds = 0;
+
+            double hashesPerSecond() const { return seconds > 0 ? hashes / seconds : 0; }
+        };
+
+        struct Result
+        {
+            bool found = false;
+            bool cancelled = false;
+            uint64_t nonce = 0;
+            std::string hash;
+            std::vector<ThreadStats> threads;
+
+            uint64_t hashes() const
+            {
+                uint64_t total = 0;
+                for (const auto &t : threads)
+                    total += t.hashes;
+                return total;
+            }
+        };
+
+        static Result mine(const BlockHeader &header)
+        {
+            return mine(header, Options());
+        }
+
+        static Result mine(const BlockHeader &header, const Options &options)
+        {
+            const uint64_t NONE = std::numeric_limits<uint64_t>::max();
+            const uint64_t CANCEL_CHECK_INTERVAL = 1024;
+
+            Result result;
+            size_t threadCount = std::max<size_t>(1, options.threads);
+            uint64_t rangeSize = std::max<uint64_t>(1, options.rangeSize);
+            uint64_t span = options.endNonce > options.startNonce ? options.endNonce - options.startNonce : 0;
+            uint64_t ranges = span / rangeSize + (span % rangeSize != 0);
+
+            std::atomic<uint64_t> nextRange(0);
+            std::atomic<uint64_t> best(NONE);
+            std::atomic<bool> cancelled(false);
+            std::mutex mutex;
+            result.threads.resize(threadCount);
+
+            auto isCancelled = [&]()
+            {
+                if (options.cancel && options.cancel->load(std::memory_order_relaxed))
+                    cancelled.store(true, std::memory_order_relaxed);
+                return cancelled.load(std::memory_order_relaxed);
+            };
+
+            const tin::SHA256::State midstate = header.midstate();
+            const Target target = header.target();
+            uint8_t baseTail[BlockHeader::TAIL_SIZE];
+            header.serializeTail(baseTail);
+
+            auto worker = [&](size_t id)
+            {
+                uint8_t tail[BlockHeader::TAIL_SIZE];
+                std::memcpy(tail, baseTail, sizeof(tail));
+                ThreadStats &stats = result.threads[id];
+                auto start = std::chrono::steady_clock::now();
+
+                while (!isCancelled())
+                {
+                    uint64_t range = nextRange.fetch_add(1, std::memory_order_relaxed);
+                    if (range >= ranges)
+                        break;
+
+                    uint64_t first = options.startNonce + range * rangeSize;
+                    uint64_t last = first + std::min(rangeSize, options.endNonce - first);
+                    // Claimed in order, so no later range can beat the winner
+                    if (first >= best.load(std::memory_order_relaxed))
+                        break;
+
+                    for (uint64_t nonce = first; nonce < last && nonce < best.load(std::memory_order_relaxed); nonce++)
+                    {
+                        if (stats.hashes % CANCEL_CHECK_INTERVAL == 0 && isCancelled())
+                            break;
+
+                        BlockHeader::setTailNonce(tail, nonce);
+                        SHAHash digest = tin::sha256d_80(midstate, tail);
+                        stats.hashes++;
+
+                        if (target.isMetBy(digest))
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if (nonce < best.load(std::memory_order_relaxed))
+                            {
+                                best.store(nonce, std::memory_order_relaxed);
+                                result.hash = digest.toString();
+                            }
+                            break;
+                        }
+                    }
+                }
+
+                stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            };
+
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < threadCount; i++)
+            {
+                workers.emplace_back(worker, i);
+            }
+            worker(0);
+            for (auto &t : workers)
+            {
+                t.join();
+            }
+
+            // A cancelled search may have skipped lower nonces, so its
+            // candidate is not reported
+            result.cancelled = cancelled.load();
+            result.found = !result.cancelled && best.load() != NONE;
+            if (result.found)
+                result.nonce = best.load();
+            else
+                result.hash.clear();
+            return result;
+        }
+    };
+}
+
+#endif
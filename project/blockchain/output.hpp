@@ -4,6 +4,8 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include "encoding.hpp"
+#include "jsonWriter.hpp"
 
 /**
  * @todo complete all variable in Output
@@ -21,22 +23,44 @@ namespace tin_blockchain
         Output(double value, uint64_t txIndex, const std::string &addr)
             : value(value), txIndex(txIndex), addr(addr) {}
 
+        template <typename Sink>
+        void writeJson(JsonWriter<Sink> &json) const
+        {
+            json.beginObject()
+                .field("value", value)
+                .field("txIndex", txIndex)
+                .field("addr", addr)
+                .endObject();
+        }
+
         std::string toString() const
         {
-            std::ostringstream oss;
-            oss << "{"
-                << "\"value\": " << value
-                << ", \"txIndex\": " << txIndex
-                << ", \"addr\": \"" << addr << "\""
-                << "}";
-            return oss.str();
+            StringSink sink;
+            JsonWriter<StringSink> json(sink);
+            writeJson(json);
+            return sink.str;
+        }
+
+        // value (f64), txIndex (varint), addr (string)
+        size_t serializedSize() const
+        {
+            return 8 + encoding::varintSize(txIndex) + encoding::stringSize(addr);
+        }
+
+        void serialize(encoding::Writer &writer) const
+        {
+            writer.float64(value);
+            writer.varint(txIndex);
+            writer.string(addr);
         }
 
-        std::string serialize() const
+        static Output deserialize(encoding::Reader &reader)
         {
-            std::ostringstream oss;
-            oss << std::hex << std::setw(16) << std::setfill('0') << (uint64_t)(value * 1000000000) << addr;
-            return oss.str();
+            double value = reader.float64();
+            uint64_t txIndex = reader.varint();
+            size_t length;
+            const char *addr = reader.string(length);
+            return Output(value, txIndex, std::string(addr, length));
         }
     };
 }
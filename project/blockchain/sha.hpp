@@ -2,10 +2,11 @@
 #define BLOCKCHAIN_SHA256
 
 #include "../../global/security/SHA256/SHA256.hpp"
+#include "../../global/security/Digest/Digest.hpp"
 #include <vector>
 #include <array>
 
-typedef std::array<uint8_t, tin::SHA256::DIGEST_LENGTH> SHAHash;
+typedef tin::Digest SHAHash;
 
 std::string sha256(const std::string &data)
 {
@@ -15,20 +16,27 @@ std::string sha256(const std::string &data)
     return tin::SHA256::toString(digest);
 }
 
-SHAHash sha256(std::vector<uint8_t> &data)
+SHAHash sha256(const std::vector<uint8_t> &data)
 {
     tin::SHA256 sha;
     sha.update(data);
     return sha.digest();
 }
 
-SHAHash double_sha256(std::vector<uint8_t> &data)
+// SHA256(SHA256(data)). digest() does not reset a SHA256, so each pass
+// needs its own hasher.
+SHAHash sha256d(const uint8_t *data, size_t size)
 {
-    tin::SHA256 sha;
-    sha.update(data);
-    auto first_digest = sha.digest();
-    sha.update(first_digest);
-    return sha.digest();
+    tin::SHA256 first;
+    first.update(data, size);
+    tin::SHA256 second;
+    second.update(first.digest());
+    return second.digest();
+}
+
+SHAHash double_sha256(const std::vector<uint8_t> &data)
+{
+    return sha256d(data.data(), data.size());
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef BLOCKCHAIN_TARGET
+#define BLOCKCHAIN_TARGET
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include "sha.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * 256-bit proof-of-work target, stored big-endian in the same byte order
+     * as the digest's hex string. A hash meets the target when, read as a
+     * 256-bit number, it is not above it, which is one memcmp on the raw
+     * digest instead of formatting it as hex.
+     */
+    class Target
+    {
+    public:
+        std::array<uint8_t, 32> bytes;
+
+        // Target of `difficulty` leading zero hex digits: 2^(256 - 4 * difficulty) - 1
+        static Target fromDifficulty(int difficulty)
+        {
+            Target target;
+            target.bytes.fill(0xff);
+
+            size_t zeroBits = difficulty <= 0 ? 0 : std::min<size_t>(256, size_t(difficulty) * 4);
+            std::memset(target.bytes.data(), 0, zeroBits / 8);
+            if (zeroBits % 8 != 0)
+            {
+                target.bytes[zeroBits / 8] = 0x0f;
+            }
+            return target;
+        }
+
+        bool isMetBy(const uint8_t *hash) const
+        {
+            return std::memcmp(hash, bytes.data(), bytes.size()) <= 0;
+        }
+
+        bool isMetBy(const SHAHash &hash) const
+        {
+            return isMetBy(hash.data());
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include "../blockStore.hpp"
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+
+static tin_blockchain::Block makeBlock(uint32_t height, size_t txCount)
+{
+    std::vector<tin_blockchain::Transaction> transactions;
+    for (size_t i = 0; i < txCount; i++)
+    {
+        uint64_t id = uint64_t(height) * 1000 + i;
+        transactions.emplace_back(int(i), id, 1700000000 + height, int(height), int(height),
+                                  std::vector<tin_blockchain::Input>{tin_blockchain::Input(tin_blockchain::PrevOut(1.5, id, "in" + std::to_string(id)))},
+                                  std::vector<tin_blockchain::Output>{tin_blockchain::Output(0.5 * i, id, "out" + std::to_string(id))});
+    }
+    tin_blockchain::BlockHeader header("", tin_blockchain::MerkleTree::computeMerkleRoot(transactions), 1700000000 + height, 1);
+    header.nonce = height;
+    return tin_blockchain::Block(header, transactions);
+}
+
+static void checkBlock(const tin_blockchain::BlockStore &store, uint32_t height, size_t txCount)
+{
+    tin_blockchain::Block expected = makeBlock(height, txCount);
+    std::vector<uint8_t> bytes;
+    store.readBlock(height, bytes);
+    assert(bytes == expected.serialize());
+
+    for (const auto &tx : expected.transactions)
+    {
+        tin_blockchain::BlockStore::TxLocation at;
+        assert(store.findTransaction(tx.txid, at));
+        assert(at.height == height);
+        assert(store.transaction(tx.txid).serialize() == tx.serialize());
+    }
+}
+
+void test_appendAndLookup()
+{
+    const std::string dir = "block_store_test.tmp";
+    std::filesystem::remove_all(dir);
+
+    // Small segments and enough transactions to grow the txid table
+    tin_blockchain::BlockStore::Options options;
+    options.segmentSize = 64 << 10;
+    options.syncInterval = 16;
+
+    const uint32_t BLOCKS = 240;
+    const size_t TXS = 80;
+    {
+        tin_blockchain::BlockStore store(dir, options);
+        assert(store.empty());
+        for (uint32_t h = 0; h < BLOCKS; h++)
+        {
+            assert(store.append(makeBlock(h, TXS)) == h);
+        }
+        assert(store.size() == BLOCKS);
+        assert(store.syncedSize() == BLOCKS);
+        assert(store.location(BLOCKS - 1).segment > 1);
+
+        checkBlock(store, 0, TXS);
+        checkBlock(store, 117, TXS);
+        assert(store.block(BLOCKS - 1).header.nonce == BLOCKS - 1);
+
+        tin_blockchain::BlockStore::TxLocation at;
+        assert(!store.findTransaction(SHAHash(), at));
+    }
+
+    // Reopening reads the indexes, not the segments
+    {
+        tin_blockchain::BlockStore store(dir, options);
+        assert(store.size() == BLOCKS);
+        for (uint32_t h = 0; h < BLOCKS; h += 37)
+        {
+            checkBlock(store, h, TXS);
+        }
+        store.append(makeBlock(BLOCKS, 3));
+        checkBlock(store, BLOCKS, 3);
+    }
+
+    tin_blockchain::BlockStore store(dir, options);
+    assert(store.size() == BLOCKS + 1);
+    checkBlock(store, BLOCKS, 3);
+
+    bool threw = false;
+    try
+    {
+        store.location(BLOCKS + 1);
+    }
+    catch (const std::out_of_range &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    std::filesystem::remove_all(dir);
+}
+
+void test_unsyncedTailIsDropped()
+{
+    const std::string dir = "block_store_crash.tmp";
+    const std::string copy = dir + ".copy";
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove_all(copy);
+
+    tin_blockchain::BlockStore::Options options;
+    options.syncInterval = 1000;
+
+    {
+        tin_blockchain::BlockStore store(dir, options);
+        for (uint32_t h = 0; h < 10; h++)
+            store.append(makeBlock(h, 5));
+        store.sync();
+        for (uint32_t h = 10; h < 15; h++)
+            store.append(makeBlock(h, 5));
+        assert(store.syncedSize() == 10);
+
+        // The files as a crash would leave them: unsynced blocks present in
+        // the segment and the txid table, but not counted
+        std::filesystem::copy(dir, copy);
+    }
+
+    tin_blockchain::BlockStore store(copy, options);
+    assert(store.size() == 10);
+    checkBlock(store, 9, 5);
+
+    tin_blockchain::BlockStore::TxLocation at;
+    tin_blockchain::Block lost = makeBlock(12, 5);
+    assert(!store.findTransaction(lost.transactions[0].txid, at));
+
+    // A different block at a dropped height is indexed cleanly
+    assert(store.append(makeBlock(100, 4)) == 10);
+    std::vector<uint8_t> bytes;
+    store.readBlock(10, bytes);
+    assert(bytes == makeBlock(100, 4).serialize());
+    assert(store.findTransaction(makeBlock(100, 4).transactions[3].txid, at) && at.height == 10);
+
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove_all(copy);
+}
+
+// One block past 70% of the initial 1 << 14 txid slots grows the table
+// in the middle of append()
+void test_tableGrowsInsideBlock()
+{
+    const std::string dir = "block_store_grow.tmp";
+    std::filesystem::remove_all(dir);
+
+    const size_t TXS = 12000;
+    {
+        tin_blockchain::BlockStore store(dir);
+        store.append(makeBlock(0, 3));
+        store.append(makeBlock(1, TXS));
+        checkBlock(store, 0, 3);
+        checkBlock(store, 1, TXS);
+    }
+
+    tin_blockchain::BlockStore store(dir);
+    checkBlock(store, 1, TXS);
+    std::filesystem::remove_all(dir);
+}
+
+int main()
+{
+    test_appendAndLookup();
+    test_unsyncedTailIsDropped();
+    test_tableGrowsInsideBlock();
+
+    std::cout << "All block store tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,299 @@
+#include "../blockValidator.hpp"
+#include <cassert>
+#include <iostream>
+
+using tin_blockchain::Block;
+using tin_blockchain::BlockValidator;
+using tin_blockchain::Transaction;
+using tin_blockchain::UtxoSet;
+
+static const size_t TXS_PER_BLOCK = 400;
+
+static Block finish(const std::string &previousHash, const std::vector<Transaction> &transactions)
+{
+    tin_blockchain::BlockHeader header(previousHash, tin_blockchain::MerkleTree::computeMerkleRoot(transactions), 1700000000, 1);
+    Block block(header, transactions);
+    block.mine();
+    return block;
+}
+
+// Block 0 mints two outputs per transaction. Every later block spends both
+// outputs of the matching transaction of the block before. The first
+// transaction of each block has a third output, which the last transaction
+// of the same block spends.
+static std::vector<Block> makeChain(size_t blocks)
+{
+    std::vector<Block> chain;
+    for (size_t b = 0; b < blocks; b++)
+    {
+        std::vector<Transaction> transactions;
+        for (size_t i = 0; i < TXS_PER_BLOCK; i++)
+        {
+            uint64_t txIndex = b * 100000 + i;
+            std::vector<tin_blockchain::Input> inputs;
+            if (b > 0)
+            {
+                const Transaction &parent = chain.back().transactions[i];
+                for (uint32_t n = 0; n < 2; n++)
+                    inputs.emplace_back(tin_blockchain::PrevOut(parent.out[n].value, parent.txIndex, parent.out[n].addr, n));
+            }
+            if (b > 0 && i == TXS_PER_BLOCK - 1)
+            {
+                const Transaction &sibling = transactions[0];
+                inputs.emplace_back(tin_blockchain::PrevOut(sibling.out[2].value, sibling.txIndex, sibling.out[2].addr, 2));
+            }
+
+            std::vector<tin_blockchain::Output> out = {
+                tin_blockchain::Output(50, txIndex, "a" + std::to_string(i)),
+                tin_blockchain::Output(25, txIndex, "b" + std::to_string(i))};
+            if (i == 0)
+                out.emplace_back(0, txIndex, "c");
+            transactions.emplace_back(0, txIndex, 1700000000, int(b), int(b), inputs, out);
+        }
+        chain.push_back(finish(b == 0 ? "" : chain.back().header.hash, transactions));
+    }
+    return chain;
+}
+
+static void expectFailure(const Block &block, const UtxoSet &utxos, BlockValidator::Stage stage)
+{
+    BlockValidator validator;
+    BlockValidator::Result result = validator.validate(block, utxos);
+    assert(!result.valid);
+    assert(result.stage == stage);
+    assert(!result.error.empty());
+}
+
+void test_initialSync()
+{
+    std::vector<Block> chain = makeChain(40);
+    UtxoSet utxos;
+    BlockValidator validator;
+    std::vector<UtxoSet::BlockUndo> undos(chain.size());
+
+    for (size_t b = 0; b < chain.size(); b++)
+    {
+        BlockValidator::Result result = validator.connect(chain[b], utxos, undos[b]);
+        if (!result.valid)
+            std::cerr << BlockValidator::stageName(result.stage) << ": " << result.error << std::endl;
+        assert(result.valid);
+    }
+    // The tip's outputs, less the one spent inside it, plus the extra
+    // output of block 0's first transaction, which nothing spends
+    assert(utxos.size() == 2 * TXS_PER_BLOCK + 1);
+
+    const BlockValidator::Stats &stats = validator.stats();
+    assert(stats.blocks == chain.size());
+    std::cout << "Validation: " << tin::ThreadPool::shared().size() << " threads, "
+              << stats.blocksPerSecond() << " blocks/s, " << stats.transactionsPerSecond() << " tx/s" << std::endl;
+
+    // Replaying a connected block double-spends its inputs
+    expectFailure(chain.back(), utxos, BlockValidator::INPUTS);
+}
+
+void test_failures()
+{
+    std::vector<Block> chain = makeChain(2);
+    UtxoSet utxos;
+    UtxoSet::BlockUndo undo;
+    BlockValidator validator;
+    assert(validator.connect(chain[0], utxos, undo).valid);
+    assert(validator.validate(chain[1], utxos).valid);
+
+    // Edited after hashing
+    Block tampered = chain[1];
+    tampered.transactions[7].fee = 1;
+    expectFailure(tampered, utxos, BlockValidator::TRANSACTION_HASH);
+
+    // Rehashed, so only the Merkle root is stale
+    tampered.transactions[7].createHash();
+    expectFailure(tampered, utxos, BlockValidator::MERKLE_ROOT);
+
+    Block badNonce = chain[1];
+    do
+    {
+        badNonce.header.nonce++;
+    } while (badNonce.header.meetsDifficulty(badNonce.header.computeDigest()));
+    expectFailure(badNonce, utxos, BlockValidator::PROOF_OF_WORK);
+
+    Block staleHash = chain[1];
+    staleHash.header.hash = chain[0].header.hash;
+    expectFailure(staleHash, utxos, BlockValidator::PROOF_OF_WORK);
+
+    // Each of these is rebuilt with a valid hash, root and proof of work
+    auto rebuild = [&](std::vector<Transaction> transactions)
+    {
+        for (auto &tx : transactions)
+            tx.createHash();
+        return finish(chain[0].header.hash, transactions);
+    };
+
+    std::vector<Transaction> transactions = chain[1].transactions;
+    transactions[3].inputs[0].prev_out.value += 1;
+    expectFailure(rebuild(transactions), utxos, BlockValidator::INPUTS);
+
+    transactions = chain[1].transactions;
+    transactions[3].inputs[1].prev_out.n = 9;
+    expectFailure(rebuild(transactions), utxos, BlockValidator::INPUTS);
+
+    transactions = chain[1].transactions;
+    transactions[3].out[0].value = 1000;
+    expectFailure(rebuild(transactions), utxos, BlockValidator::INPUTS);
+
+    transactions = chain[1].transactions;
+    transactions[4].inputs = transactions[3].inputs;
+    expectFailure(rebuild(transactions), utxos, BlockValidator::INPUTS);
+
+    // The in-block spend must come after the transaction it spends
+    transactions = chain[1].transactions;
+    std::swap(transactions.front(), transactions.back());
+    expectFailure(rebuild(transactions), utxos, BlockValidator::INPUTS);
+
+    assert(validator.validate(rebuild(chain[1].transactions), utxos).valid);
+
+    // New coins only from the coinbase outside the genesis block
+    transactions = chain[1].transactions;
+    transactions[0].inputs.clear();
+    transactions[0].out[0].value = 1000;
+    transactions[0].out[2].value = 0;
+    assert(validator.validate(rebuild(transactions), utxos).valid);
+    transactions[5].inputs.clear();
+    BlockValidator::Result minted = validator.validate(rebuild(transactions), utxos);
+    assert(!minted.valid && minted.stage == BlockValidator::INPUTS && minted.transaction == 5);
+
+    // A second coinbase with an unspent txIndex fails validation rather
+    // than throwing out of connect()
+    Transaction coinbase(0, 7, 1700000000, 0, 0, {}, {tin_blockchain::Output(50, 7, "miner")});
+    UtxoSet fresh;
+    assert(validator.connect(finish("", {coinbase}), fresh, undo).valid);
+    Block again = finish("", {coinbase});
+    again.header.timestamp++;
+    again.mine();
+    BlockValidator::Result result = validator.connect(again, fresh, undo);
+    assert(!result.valid && result.stage == BlockValidator::INPUTS);
+    assert(fresh.size() == 1);
+}
+
+void test_graph()
+{
+    // 0 <- 2 <- 3, 1 independent, 4 spends 0 and 3, 5 names the later 6
+    std::vector<Transaction> transactions;
+    auto spend = [&](uint64_t txIndex, std::vector<uint64_t> parents)
+    {
+        std::vector<tin_blockchain::Input> inputs;
+        for (uint64_t p : parents)
+            inputs.emplace_back(tin_blockchain::PrevOut(1, p, "x", 0));
+        transactions.emplace_back(0, txIndex, 0, 0, 0, inputs, std::vector<tin_blockchain::Output>{tin_blockchain::Output(1, txIndex, "x")});
+    };
+    spend(100, {});
+    spend(101, {7});
+    spend(102, {100});
+    spend(103, {102, 102});
+    spend(104, {100, 103});
+    spend(105, {106});
+    spend(106, {});
+
+    tin_blockchain::TransactionGraph graph(transactions);
+    assert(graph.position(103) == 3 && graph.position(7) == tin_blockchain::TransactionGraph::NONE);
+    assert(graph.waveCount() == 4);
+
+    std::vector<std::vector<uint32_t>> waves;
+    for (size_t k = 0; k < graph.waveCount(); k++)
+        waves.emplace_back(graph.waveBegin(k), graph.waveEnd(k));
+    assert((waves[0] == std::vector<uint32_t>{0, 1, 5, 6}));
+    assert((waves[1] == std::vector<uint32_t>{2}));
+    assert((waves[2] == std::vector<uint32_t>{3}));
+    assert((waves[3] == std::vector<uint32_t>{4}));
+    assert(graph.parentsEnd(3) - graph.parentsBegin(3) == 1);
+    assert(graph.parentsEnd(4) - graph.parentsBegin(4) == 2);
+}
+
+static bool sameResult(const BlockValidator::Result &a, const BlockValidator::Result &b)
+{
+    return a.valid == b.valid && a.stage == b.stage && a.transaction == b.transaction && a.error == b.error;
+}
+
+void test_wavesMatchSequential()
+{
+    // More workers than cores, so chunks really interleave
+    tin::ThreadPool pool(4);
+    BlockValidator validator(pool);
+
+    std::vector<Block> chain = makeChain(2);
+    UtxoSet utxos;
+    UtxoSet::BlockUndo undo;
+    assert(validator.connect(chain[0], utxos, undo).valid);
+
+    // Several defects per block, spread over waves and positions
+    uint32_t seed = 3;
+    size_t invalid = 0;
+    for (int round = 0; round < 60; round++)
+    {
+        std::vector<Transaction> transactions = chain[1].transactions;
+        int defects = round % 4;
+        for (int d = 0; d < defects; d++)
+        {
+            seed = seed * 1103515245 + 12345;
+            Transaction &tx = transactions[(seed >> 8) % transactions.size()];
+            switch ((seed >> 4) % 5)
+            {
+            case 0:
+                tx.inputs[0].prev_out.value += 1;
+                break;
+            case 1:
+                tx.out[0].value += 1000;
+                break;
+            case 2:
+                tx.inputs.push_back(transactions[(seed >> 12) % transactions.size()].inputs[0]);
+                break;
+            case 3:
+                tx.inputs[0].prev_out.txIndex = transactions.back().txIndex;
+                break;
+            case 4:
+                tx.fee = int(seed);
+                break;
+            }
+            if ((seed >> 4) % 5 != 4)
+                tx.createHash();
+        }
+
+        Block block = finish(chain[0].header.hash, transactions);
+        BlockValidator::Result waves = validator.validate(block, utxos);
+        BlockValidator::Result sequential = validator.validateSequential(block, utxos);
+        assert(sameResult(waves, sequential));
+        invalid += !waves.valid;
+    }
+    assert(invalid > 30);
+
+    // One long spend chain: every wave has a single transaction
+    std::vector<Transaction> transactions;
+    for (uint64_t i = 0; i < 300; i++)
+    {
+        std::vector<tin_blockchain::Input> inputs;
+        if (i > 0)
+            inputs.emplace_back(tin_blockchain::PrevOut(10, 500000 + i - 1, "chain", 0));
+        transactions.emplace_back(0, 500000 + i, 0, 0, 0, inputs, std::vector<tin_blockchain::Output>{tin_blockchain::Output(10, 500000 + i, "chain")});
+    }
+    Block deep = finish("", transactions);
+    assert(tin_blockchain::TransactionGraph(deep.transactions).waveCount() == 300);
+    assert(validator.validate(deep, utxos).valid);
+
+    transactions[150].out[0].value = 11;
+    transactions[150].createHash();
+    transactions[40].fee = 1;
+    Block broken = finish("", transactions);
+    BlockValidator::Result result = validator.validate(broken, utxos);
+    assert(!result.valid && result.stage == BlockValidator::TRANSACTION_HASH && result.transaction == 40);
+    assert(sameResult(result, validator.validateSequential(broken, utxos)));
+}
+
+int main()
+{
+    test_graph();
+    test_failures();
+    test_wavesMatchSequential();
+    test_initialSync();
+
+    std::cout << "All block validator tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "../block.hpp"
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+static tin_blockchain::BlockHeader makeHeader()
+{
+    tin_blockchain::BlockHeader header(sha256(std::string("prev")), sha256(std::string("root")), 1700000000, 4);
+    header.nonce = 0x0102030405060708;
+    return header;
+}
+
+void test_binaryLayout()
+{
+    tin_blockchain::BlockHeader header = makeHeader();
+    auto bytes = header.serializeBinary();
+
+    assert(tin::Hex::encode(bytes.data(), 32) == header.previousHash);
+    assert(tin::Hex::encode(bytes.data() + 32, 32) == header.merkleRoot);
+    assert(tin::Hex::encode(bytes.data() + 64, 16) == "00f1536504000000" "0807060504030201");
+
+    tin::SHA256 first;
+    first.update(bytes.data(), bytes.size());
+    tin::SHA256 second;
+    second.update(first.digest());
+    assert(header.computeHash() == tin::SHA256::toString(second.digest()));
+
+    // Empty hash fields (genesis, no transactions) encode as zeros
+    tin_blockchain::BlockHeader genesis("", "", 0, 1);
+    auto zeros = genesis.serializeBinary();
+    for (size_t i = 0; i < 64; i++)
+        assert(zeros[i] == 0);
+
+    bool threw = false;
+    try
+    {
+        tin_blockchain::BlockHeader("00", "", 0, 1).serializeBinary();
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_target()
+{
+    using tin_blockchain::Target;
+
+    assert(tin::Hex::encode(Target::fromDifficulty(0).bytes.data(), 32) == std::string(64, 'f'));
+    assert(tin::Hex::encode(Target::fromDifficulty(3).bytes.data(), 32) == "000" + std::string(61, 'f'));
+    assert(tin::Hex::encode(Target::fromDifficulty(4).bytes.data(), 32) == "0000" + std::string(60, 'f'));
+    assert(tin::Hex::encode(Target::fromDifficulty(64).bytes.data(), 32) == std::string(64, '0'));
+
+    // The raw compare agrees with counting leading zero hex digits
+    tin_blockchain::BlockHeader header = makeHeader();
+    for (int difficulty = 0; difficulty <= 3; difficulty++)
+    {
+        header.difficulty = difficulty;
+        for (uint64_t nonce = 0; nonce < 2000; nonce++)
+        {
+            header.nonce = nonce;
+            std::string hash = header.computeHash();
+            bool expected = hash.compare(0, difficulty, std::string(difficulty, '0')) == 0;
+            assert(header.meetsDifficulty(header.computeDigest()) == expected);
+            assert(header.meetsDifficulty(hash) == expected);
+        }
+    }
+}
+
+void test_mine()
+{
+    tin_blockchain::BlockHeader header = makeHeader();
+    header.difficulty = 3;
+    header.nonce = 0;
+    tin_blockchain::Block block(header, {});
+
+    std::string hash = block.mine();
+    assert(hash.compare(0, 3, "000") == 0);
+    assert(block.header.hash == hash);
+    assert(block.header.computeHash() == hash);
+
+    // No lower nonce qualifies
+    tin_blockchain::BlockHeader probe = block.header;
+    for (uint64_t nonce = 0; nonce < block.header.nonce; nonce++)
+    {
+        probe.nonce = nonce;
+        assert(!probe.meetsDifficulty(probe.computeDigest()));
+    }
+}
+
+int main()
+{
+    test_binaryLayout();
+    test_target();
+    test_mine();
+
+    std::cout << "All header tests passed" << std::endl;
+    return 0;
+}
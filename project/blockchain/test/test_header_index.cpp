@@ -0,0 +1,186 @@
+#include "../headerIndex.hpp"
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+using tin_blockchain::BlockHeader;
+using tin_blockchain::ChainWork;
+using tin_blockchain::HeaderIndex;
+
+static uint64_t nextTimestamp = 0;
+
+// A header on `parent` that meets `difficulty`; timestamps keep siblings distinct
+static BlockHeader makeHeader(const HeaderIndex &index, uint32_t parent, int difficulty = 0)
+{
+    std::string previousHash = parent == HeaderIndex::NONE ? "" : index[parent].hash.toString();
+    BlockHeader header(previousHash, "", nextTimestamp++, difficulty);
+    while (!header.meetsDifficulty(header.computeDigest()))
+        header.nonce++;
+    return header;
+}
+
+static uint32_t slowAncestor(const HeaderIndex &index, uint32_t i, uint32_t height)
+{
+    while (index[i].height > height)
+        i = index[i].parent;
+    return i;
+}
+
+static uint32_t slowCommonAncestor(const HeaderIndex &index, uint32_t a, uint32_t b)
+{
+    while (a != b)
+    {
+        if (index[a].height >= index[b].height)
+            a = index[a].parent;
+        else
+            b = index[b].parent;
+    }
+    return a;
+}
+
+static bool throwsInvalid(HeaderIndex &index, const BlockHeader &header)
+{
+    try
+    {
+        index.add(header);
+    }
+    catch (const std::invalid_argument &)
+    {
+        return true;
+    }
+    return false;
+}
+
+void test_chainWork()
+{
+    assert(ChainWork::ofDifficulty(0).limbs[0] == 1);
+    assert(ChainWork::ofDifficulty(1).limbs[0] == 16);
+    assert(ChainWork::ofDifficulty(16).limbs[1] == 1);
+    assert(ChainWork::ofDifficulty(63).limbs[3] == uint64_t(1) << 60);
+    assert(ChainWork::ofDifficulty(64) == ChainWork::ofDifficulty(63));
+
+    // Carries ripple across limbs
+    ChainWork work;
+    work.limbs = {UINT64_MAX, UINT64_MAX, 0, 0};
+    work += ChainWork::ofDifficulty(0);
+    assert(work.limbs[0] == 0 && work.limbs[1] == 0 && work.limbs[2] == 1);
+    assert(ChainWork::ofDifficulty(15) < work && !(work < ChainWork::ofDifficulty(15)));
+    assert(work.toString() == std::string(31, '0') + "1" + std::string(32, '0'));
+}
+
+void test_skipHeights()
+{
+    for (uint32_t h = 1; h < 100000; h++)
+        assert(HeaderIndex::skipHeight(h) < h);
+    assert(HeaderIndex::skipHeight(1) == 0);
+    assert(HeaderIndex::skipHeight(8) == 0);
+    assert(HeaderIndex::skipHeight(12) == 8);
+    assert(HeaderIndex::skipHeight(13) == 1);
+}
+
+void test_longChain()
+{
+    const uint32_t COUNT = 200000;
+    HeaderIndex index;
+    index.reserve(COUNT);
+
+    uint32_t last = HeaderIndex::NONE;
+    for (uint32_t h = 0; h < COUNT; h++)
+    {
+        uint32_t position = index.add(makeHeader(index, last));
+        assert(position == h && index[position].height == h);
+        last = position;
+    }
+
+    assert(index.size() == COUNT && index.tip() == last);
+    assert(index[last].chainWork.limbs[0] == COUNT);
+    for (uint32_t h = 0; h < COUNT; h += 997)
+    {
+        assert(index.ancestor(last, h) == h);
+        assert(index.atHeight(h) == h);
+        assert(index.find(index[h].hash) == h);
+    }
+    assert(index.ancestor(7, 8) == HeaderIndex::NONE);
+
+    // 80-byte entries plus the table, not a node per header
+    assert(index.memoryUsage() / COUNT < 100);
+}
+
+void test_forkChoice()
+{
+    HeaderIndex index;
+    std::vector<uint32_t> main{index.add(makeHeader(index, HeaderIndex::NONE))};
+    for (int i = 1; i < 50; i++)
+        main.push_back(index.add(makeHeader(index, main.back())));
+    assert(index.tip() == main.back());
+
+    // Five headers of difficulty 1 (work 16 each) outweigh the 29 after the fork
+    std::vector<uint32_t> fork{main[20]};
+    for (int i = 0; i < 5; i++)
+        fork.push_back(index.add(makeHeader(index, fork.back(), 1)));
+    assert(index.tip() == fork.back());
+    assert(index[fork.back()].height == 25);
+    assert(index.lastCommonAncestor(main.back(), fork.back()) == main[20]);
+    assert(index.lastCommonAncestor(fork[3], main[20]) == main[20]);
+    assert(index.atHeight(22) == fork[2]);
+    assert(!index.onMainChain(main[30]) && index.onMainChain(main[20]));
+
+    // Equal work does not take the tip from the first one seen
+    uint32_t rival = index.add(makeHeader(index, fork[4], 1));
+    assert(index[rival].chainWork == index[fork.back()].chainWork);
+    assert(index.tip() == fork.back());
+}
+
+void test_randomTree()
+{
+    HeaderIndex index;
+    index.add(makeHeader(index, HeaderIndex::NONE));
+    uint32_t seed = 5;
+    for (int i = 1; i < 3000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        // Mostly extend recent headers so branches get long
+        uint32_t back = (seed >> 16) % 8 == 0 ? (seed >> 4) % index.size() : (seed >> 4) % 4;
+        uint32_t parent = uint32_t(index.size() - 1 - std::min<size_t>(back, index.size() - 1));
+        index.add(makeHeader(index, parent));
+    }
+
+    for (int k = 0; k < 3000; k++)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint32_t a = (seed >> 4) % index.size();
+        seed = seed * 1103515245 + 12345;
+        uint32_t b = (seed >> 4) % index.size();
+        uint32_t height = (seed >> 8) % (index[a].height + 1);
+        assert(index.ancestor(a, height) == slowAncestor(index, a, height));
+        assert(index.lastCommonAncestor(a, b) == slowCommonAncestor(index, a, b));
+    }
+}
+
+void test_rejects()
+{
+    HeaderIndex index;
+    BlockHeader genesis = makeHeader(index, HeaderIndex::NONE);
+    uint32_t root = index.add(genesis);
+    assert(index.add(genesis) == root && index.size() == 1);
+
+    // A second root, a missing parent, and a hash that misses its difficulty
+    assert(throwsInvalid(index, makeHeader(index, HeaderIndex::NONE)));
+    assert(throwsInvalid(index, BlockHeader(sha256(std::string("nowhere")), "", 1, 0)));
+    BlockHeader weak(index[root].hash.toString(), "", 1, 60);
+    assert(throwsInvalid(index, weak));
+    assert(index.size() == 1 && index.tip() == root);
+}
+
+int main()
+{
+    test_chainWork();
+    test_skipHeights();
+    test_longChain();
+    test_forkChoice();
+    test_randomTree();
+    test_rejects();
+
+    std::cout << "All header index tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "../block.hpp"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+static std::string readFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream oss;
+    oss << file.rdbuf();
+    return oss.str();
+}
+
+void test_writer()
+{
+    tin_blockchain::StringSink sink;
+    tin_blockchain::JsonWriter<tin_blockchain::StringSink> json(sink);
+
+    json.beginObject()
+        .field("text", "quote\" slash\\ tab\t")
+        .field("int", -42)
+        .field("big", uint64_t(18446744073709551615ull))
+        .field("double", 4.92e6)
+        .field("fraction", 0.1)
+        .field("flag", true)
+        .key("empty")
+        .beginArray()
+        .endArray()
+        .key("list")
+        .beginArray()
+        .value(1)
+        .beginObject()
+        .endObject()
+        .value("x")
+        .endArray()
+        .endObject();
+
+    assert(sink.str == "{\"text\": \"quote\\\" slash\\\\ tab\\u0009\", \"int\": -42, \"big\": 18446744073709551615, "
+                       "\"double\": 4920000, \"fraction\": 0.1, \"flag\": true, \"empty\": [], \"list\": [1, {}, \"x\"]}");
+}
+
+void test_transactionJson()
+{
+    tin_blockchain::Transaction tx(157080, 6017350324759491, 1500839760, 477230, 477230,
+                                   {tin_blockchain::Input(tin_blockchain::PrevOut(4.92e6, 40031577549905, "1GLc"))},
+                                   {tin_blockchain::Output(3.744e6, 6017350324759491, "1AG2")});
+
+    assert(tx.toString() == "{\"hash\": \"" + tx.hash + "\", \"fee\": 157080, \"time\": 1500839760, "
+                                                       "\"blockIndex\": 477230, \"blockHeight\": 477230, "
+                                                       "\"inputs\": [{\"prev_out\": {\"value\": 4920000, \"txIndex\": 40031577549905, \"n\": 0, \"addr\": \"1GLc\"}}], "
+                                                       "\"out\": [{\"value\": 3744000, \"txIndex\": 6017350324759491, \"addr\": \"1AG2\"}]}");
+}
+
+void test_fileExport()
+{
+    const std::string path = "json_test.tmp";
+
+    std::vector<tin_blockchain::Transaction> transactions;
+    for (uint64_t i = 0; i < 2000; i++)
+    {
+        transactions.emplace_back(int(i), i, 1700000000, 1, 2,
+                                  std::vector<tin_blockchain::Input>{tin_blockchain::Input(tin_blockchain::PrevOut(1.5, i, std::string(40, 'p')))},
+                                  std::vector<tin_blockchain::Output>{tin_blockchain::Output(0.25, i, std::string(40, 'o'))});
+    }
+    tin_blockchain::Block block(tin_blockchain::BlockHeader("", "", 1700000000, 1), transactions);
+
+    // Larger than the sink buffer, so it is flushed several times
+    std::string expected = block.toString();
+    assert(expected.size() > 2 * tin_blockchain::FdSink::BUFFER_SIZE);
+
+    block.writeToJsonFile(path);
+    assert(readFile(path) == expected);
+
+    // A chain streamed as one array
+    {
+        tin_blockchain::FdSink sink(path);
+        tin_blockchain::JsonWriter<tin_blockchain::FdSink> json(sink);
+        json.beginArray();
+        for (int i = 0; i < 3; i++)
+            block.writeJson(json);
+        json.endArray();
+    }
+    assert(readFile(path) == "[" + expected + ", " + expected + ", " + expected + "]");
+
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    test_writer();
+    test_transactionJson();
+    test_fileExport();
+
+    std::cout << "All JSON tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,304 @@
+#include "../jsonReader.hpp"
+#include <cassert>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <cstdio>
+
+// Abridged temp/transaction.json: every field kept, long scripts shortened
+static const char *SAMPLE = R"({
+  "hash": "74d804190b56d7d07f6d7a41456348edfee7bf0ac71fba925c76a86971455bb6",
+  "ver": 1,
+  "vin_sz": 1,
+  "vout_sz": 2,
+  "size": 225,
+  "weight": 900,
+  "fee": 157080,
+  "relayed_by": "0.0.0.0",
+  "lock_time": 477228,
+  "tx_index": 6017350324759491,
+  "double_spend": false,
+  "time": 1500839760,
+  "block_index": 477230,
+  "block_height": 477230,
+  "inputs": [
+    {
+      "sequence": 4294967294,
+      "witness": "",
+      "script": "473044022036be6403aeb4e0e6fd54720b328d9d81",
+      "index": 0,
+      "prev_out": {
+        "type": 0,
+        "spent": true,
+        "value": 4.92e6,
+        "n": 1,
+        "tx_index": 40031577549905,
+        "script": "76a914a8174c0d3c0a6c1a1f36b1c0d9fab5a0b1f5f3e788ac",
+        "addr": "1GLcRqmDvkmHtNCMcrmJ2a4A4M4tbE8vaW",
+        "spending_outpoints": [
+          {
+            "tx_index": 6017350324759491,
+            "n": 0
+          }
+        ]
+      }
+    }
+  ],
+  "out": [
+    {
+      "type": 0,
+      "spent": true,
+      "value": 3.744e6,
+      "spending_outpoints": [{"tx_index": 1, "n": 0}],
+      "n": 0,
+      "tx_index": 6017350324759491,
+      "script": "76a914",
+      "addr": "1AG2Z9Qm4dNVYGWwM9ozrm3HsNEtRW4dMh"
+    },
+    {
+      "type": 0,
+      "spent": false,
+      "value": 1018920,
+      "n": 1,
+      "tx_index": 6017350324759491,
+      "script": "a914",
+      "addr": "3PgP9uXbNHqFhPDcJvZxyovdNNNDKUFJmD"
+    }
+  ]
+})";
+
+static tin_blockchain::Transaction sampleTransaction()
+{
+    return tin_blockchain::Transaction(157080, 6017350324759491, 1500839760, 477230, 477230,
+                                       {tin_blockchain::Input(tin_blockchain::PrevOut(4.92e6, 40031577549905, "1GLcRqmDvkmHtNCMcrmJ2a4A4M4tbE8vaW", 1))},
+                                       {tin_blockchain::Output(3.744e6, 6017350324759491, "1AG2Z9Qm4dNVYGWwM9ozrm3HsNEtRW4dMh"),
+                                        tin_blockchain::Output(1018920, 6017350324759491, "3PgP9uXbNHqFhPDcJvZxyovdNNNDKUFJmD")});
+}
+
+// Byte-at-a-time reference for JsonIndexer. Like the indexer, a backslash
+// cancels the next quote or backslash even outside strings, where valid
+// JSON never has one.
+static std::vector<uint32_t> referenceIndex(const std::string &json)
+{
+    std::vector<uint32_t> indexes;
+    bool inString = false;
+    bool escaped = false;
+    for (size_t i = 0; i < json.size(); i++)
+    {
+        char c = json[i];
+        if (c == '"' && !escaped)
+        {
+            inString = !inString;
+            indexes.push_back(i);
+        }
+        else if (!inString && (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ','))
+        {
+            indexes.push_back(i);
+        }
+        escaped = c == '\\' && !escaped;
+    }
+    return indexes;
+}
+
+void test_indexer()
+{
+    // Backslash runs of every length, across block boundaries
+    const char alphabet[] = {'"', '\\', '{', '}', '[', ']', ':', ',', 'a', ' '};
+    uint32_t seed = 1;
+    std::vector<uint32_t> indexes;
+
+    for (size_t length = 0; length < 400; length += 3)
+    {
+        for (int round = 0; round < 20; round++)
+        {
+            std::string json;
+            for (size_t i = 0; i < length; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                json += alphabet[(seed >> 16) % sizeof(alphabet)];
+            }
+
+            std::vector<uint32_t> expected = referenceIndex(json);
+            bool closed = tin_blockchain::JsonIndexer::index(json.data(), json.size(), indexes);
+
+            size_t quotes = 0;
+            for (uint32_t i : expected)
+                quotes += json[i] == '"';
+            assert(closed == (quotes % 2 == 0));
+            assert(indexes == expected);
+        }
+    }
+
+    std::string escaped = std::string(70, 'x') + "\"a\\\\\\\"b\\\\\",{}";
+    assert(tin_blockchain::JsonIndexer::index(escaped.data(), escaped.size(), indexes));
+    assert(indexes == referenceIndex(escaped));
+    assert(indexes.size() == 5);
+}
+
+void test_sample()
+{
+    tin_blockchain::TransactionJsonReader reader;
+    std::vector<tin_blockchain::Transaction> transactions = reader.parse(SAMPLE);
+    assert(transactions.size() == 1);
+
+    const tin_blockchain::Transaction &tx = transactions[0];
+    tin_blockchain::Transaction expected = sampleTransaction();
+    assert(tx.fee == 157080);
+    assert(tx.txIndex == 6017350324759491ull);
+    assert(tx.time == 1500839760);
+    assert(tx.blockIndex == 477230 && tx.blockHeight == 477230);
+    assert(tx.inputs.size() == 1 && tx.out.size() == 2);
+    assert(tx.inputs[0].prev_out.value == 4.92e6);
+    assert(tx.inputs[0].prev_out.txIndex == 40031577549905ull);
+    assert(tx.inputs[0].prev_out.n == 1);
+    assert(tx.out[1].addr == "3PgP9uXbNHqFhPDcJvZxyovdNNNDKUFJmD");
+    assert(tx.txid == expected.txid);
+    assert(tx.serialize() == expected.serialize());
+
+    // Arrays, and documents written by writeJson()
+    std::string array = std::string("[") + SAMPLE + ", " + expected.toString() + "]  \n";
+    transactions = reader.parse(array);
+    assert(transactions.size() == 2);
+    assert(transactions[0].txid == expected.txid);
+    // writeJson() leaves out the top-level tx_index
+    assert(transactions[1].txIndex == 0 && transactions[1].fee == expected.fee);
+    assert(transactions[1].out[0].txIndex == expected.out[0].txIndex && transactions[1].out[1].addr == expected.out[1].addr);
+
+    assert(reader.parse("[]").empty());
+    assert(reader.parse("  ").empty());
+}
+
+void test_escapesAndDefaults()
+{
+    tin_blockchain::TransactionJsonReader reader;
+    auto transactions = reader.parse(R"({"note": "a \"quoted\" } ] value", "out": [{"addr": "x\\y\"zA", "extra": [[], {"k": [1, 2]}]}]})");
+    assert(transactions.size() == 1);
+    assert(transactions[0].fee == 0 && transactions[0].inputs.empty());
+    assert(transactions[0].out.size() == 1);
+    assert(transactions[0].out[0].addr == "x\\y\"zA");
+    assert(transactions[0].out[0].value == 0);
+}
+
+void test_errors()
+{
+    const char *invalid[] = {
+        "{\"fee\": }",
+        "{\"fee\": 1",
+        "{\"fee\": \"1\"}",
+        "{\"fee\" 1}",
+        "{\"fee\": 1.5}",
+        "{\"time\": -1}",
+        "{\"out\": [1]}",
+        "{\"hash\": \"unterminated}",
+        "{} x",
+        "7",
+        "[{}, 3]",
+        "{1}",
+        "{\"out\": [{} x]}",
+        "{\"hash\": \"a\" \"b\"}",
+        "x {}",
+        "{\"fee\": 4294967301}",
+        "{\"fee\": -2147483649}",
+        "{\"time\": 4294967296}",
+        "{\"block_index\": 3e10}",
+        "{\"blockHeight\": 2147483648}",
+    };
+
+    tin_blockchain::TransactionJsonReader reader;
+    for (const char *json : invalid)
+    {
+        bool threw = false;
+        try
+        {
+            reader.parse(json);
+        }
+        catch (const std::invalid_argument &)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // The reader stays usable after an error
+    assert(reader.parse(SAMPLE).size() == 1);
+}
+
+void test_ndjsonStream()
+{
+    // Several STREAM_CHUNKs worth of lines
+    std::string ndjson;
+    std::vector<SHAHash> txids;
+    for (uint64_t i = 0; i < 20000; i++)
+    {
+        tin_blockchain::Transaction tx(int(i), 0, 1700000000 + i, 1, int(i % 7),
+                                       {tin_blockchain::Input(tin_blockchain::PrevOut(1.5 * i, i, std::string(40, 'p')))},
+                                       {tin_blockchain::Output(0.25, i, std::string(40, 'o'))});
+        txids.push_back(tx.txid);
+        ndjson += tx.toString();
+        ndjson += '\n';
+    }
+    assert(ndjson.size() > 3 * tin_blockchain::TransactionJsonReader::STREAM_CHUNK);
+
+    tin_blockchain::TransactionJsonReader reader;
+    size_t seen = 0;
+    bool ordered = true;
+
+    std::istringstream in(ndjson);
+    auto start = std::chrono::steady_clock::now();
+    size_t count = reader.parseNdjson(in, [&](tin_blockchain::Transaction &&tx)
+                                      { ordered = ordered && tx.txid == txids[seen++]; });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    assert(count == txids.size() && seen == txids.size() && ordered);
+    std::cout << "NDJSON: " << count << " transactions, " << ndjson.size() / 1e6 / seconds << " MB/s" << std::endl;
+
+    // No trailing newline, and a line longer than one chunk
+    std::string longLine = "{\"script\": \"" + std::string(3 * tin_blockchain::TransactionJsonReader::STREAM_CHUNK, 'f') + "\", \"fee\": 5}";
+    std::istringstream tail(std::string(SAMPLE) + "\n" + longLine + "\n" + SAMPLE);
+    std::vector<int> fees;
+    assert(reader.parseNdjson(tail, [&](tin_blockchain::Transaction &&tx)
+                              { fees.push_back(tx.fee); }) == 3);
+    assert((fees == std::vector<int>{157080, 5, 157080}));
+}
+
+// A pretty-printed array, as in temp/transaction.json, larger than the
+// NDJSON reader's chunk
+void test_largeFile()
+{
+    std::string array = "[\n";
+    size_t copies = 0;
+    while (array.size() <= 2 * tin_blockchain::TransactionJsonReader::STREAM_CHUNK)
+    {
+        array += copies++ ? ",\n" : "";
+        array += SAMPLE;
+    }
+    array += "\n]\n";
+
+    const std::string path = "json_reader_large.tmp";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << array;
+    }
+
+    tin_blockchain::TransactionJsonReader reader;
+    size_t seen = 0;
+    bool same = true;
+    size_t count = reader.parseFile(path, [&](tin_blockchain::Transaction &&tx)
+                                    { seen++; same = same && tx.fee == 157080; });
+    assert(count == copies && seen == copies && same);
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    test_indexer();
+    test_sample();
+    test_escapesAndDefaults();
+    test_errors();
+    test_ndjsonStream();
+    test_largeFile();
+
+    std::cout << "All JSON reader tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include "../mempool.hpp"
+#include <cassert>
+#include <map>
+#include <iostream>
+
+using tin_blockchain::Mempool;
+using tin_blockchain::Transaction;
+
+// One output per transaction; `parents` are spent at output 0
+static Transaction makeTx(uint64_t txIndex, int fee, std::vector<uint64_t> parents, size_t padding = 0)
+{
+    std::vector<tin_blockchain::Input> inputs;
+    for (uint64_t p : parents)
+        inputs.emplace_back(tin_blockchain::PrevOut(1, p, "x", 0));
+    if (parents.empty())
+        inputs.emplace_back(tin_blockchain::PrevOut(1, 1000000 + txIndex, "confirmed", 0));
+    std::vector<tin_blockchain::Output> out = {tin_blockchain::Output(1, txIndex, std::string(padding, 'p'))};
+    return Transaction(fee, txIndex, 0, 0, 0, inputs, out);
+}
+
+static bool hasTxIndex(const Mempool::Template &t, uint64_t txIndex)
+{
+    for (const auto &tx : t.transactions)
+        if (tx.txIndex == txIndex)
+            return true;
+    return false;
+}
+
+void test_packages()
+{
+    Mempool pool;
+    Transaction a = makeTx(1, 100, {});
+    Transaction b = makeTx(2, 300, {1});
+    Transaction c = makeTx(3, 50, {2});
+    Transaction d = makeTx(4, 10, {});
+    for (const Transaction *tx : {&a, &b, &c, &d})
+        assert(pool.add(*tx) == Mempool::ADDED);
+
+    assert(pool.size() == 4);
+    assert(pool.add(b) == Mempool::DUPLICATE);
+    // Spends what b already spends
+    assert(pool.add(makeTx(5, 999, {1})) == Mempool::CONFLICT);
+    // A parent arriving after its child
+    assert(pool.add(makeTx(6, 1, {})) == Mempool::ADDED);
+    Transaction orphanChild = makeTx(8, 1, {7});
+    assert(pool.add(orphanChild) == Mempool::ADDED);
+    assert(pool.add(makeTx(7, 1, {})) == Mempool::OUT_OF_ORDER);
+
+    Mempool::Package ancestors = pool.ancestors(c.txid);
+    assert(ancestors.count == 3 && ancestors.fee == 450);
+    assert(ancestors.size == a.serializedSize() + b.serializedSize() + c.serializedSize());
+    Mempool::Package descendants = pool.descendants(a.txid);
+    assert(descendants.count == 3 && descendants.fee == 450);
+    assert(pool.descendants(c.txid).count == 1);
+
+    // Removing b takes c with it and updates a
+    assert(pool.remove(b.txid) == 2);
+    assert(!pool.contains(c.txid));
+    assert(pool.descendants(a.txid).count == 1 && pool.descendants(a.txid).fee == 100);
+}
+
+void test_limits()
+{
+    Mempool::Limits limits;
+    limits.maxAncestors = 3;
+    limits.maxDescendants = 3;
+    Mempool pool(limits);
+
+    assert(pool.add(makeTx(1, 10, {})) == Mempool::ADDED);
+    assert(pool.add(makeTx(2, 10, {1})) == Mempool::ADDED);
+    assert(pool.add(makeTx(3, 10, {2})) == Mempool::ADDED);
+    assert(pool.add(makeTx(4, 10, {3})) == Mempool::TOO_MANY_ANCESTORS);
+    assert(pool.add(makeTx(5, 10, {1})) == Mempool::CONFLICT);
+
+    Transaction second = makeTx(6, 10, {});
+    second.out.emplace_back(1, 6, "y");
+    second.createHash();
+    assert(pool.add(second) == Mempool::ADDED);
+    Transaction spendBoth(10, 7, 0, 0, 0, {tin_blockchain::Input(tin_blockchain::PrevOut(1, 1, "x", 1)), tin_blockchain::Input(tin_blockchain::PrevOut(1, 6, "x", 0))},
+                          {tin_blockchain::Output(1, 7, "")});
+    // 1 already has descendants 2 and 3
+    assert(pool.add(spendBoth) == Mempool::TOO_MANY_DESCENDANTS);
+}
+
+void test_template()
+{
+    Mempool pool;
+    // A cheap parent whose child pays for both beats a mid-rate loner
+    Transaction parent = makeTx(1, 1, {});
+    Transaction child = makeTx(2, 5000, {1}, 100);
+    Transaction mid = makeTx(3, 1000, {});
+    Transaction low = makeTx(4, 10, {});
+    for (const Transaction *tx : {&parent, &child, &mid, &low})
+        assert(pool.add(*tx) == Mempool::ADDED);
+
+    uint64_t packageSize = parent.serializedSize() + child.serializedSize();
+    Mempool::Template t = pool.selectTemplate(packageSize);
+    assert(t.transactions.size() == 2);
+    assert(t.transactions[0].txid == parent.txid && t.transactions[1].txid == child.txid);
+    assert(t.fee == 5001 && t.size == packageSize);
+
+    // A package that does not fit is skipped, not a stopping point
+    t = pool.selectTemplate(mid.serializedSize() + low.serializedSize());
+    assert(t.transactions.size() == 2 && hasTxIndex(t, 3) && hasTxIndex(t, 4));
+
+    t = pool.selectTemplate(1 << 20);
+    assert(t.transactions.size() == 4 && t.fee == 6011);
+    assert(t.transactions[0].txid == parent.txid && t.transactions[2].txid == mid.txid);
+}
+
+void test_eviction()
+{
+    Mempool::Limits limits;
+    limits.maxMemory = 100 * (Mempool::ENTRY_OVERHEAD + 400);
+    Mempool pool(limits);
+
+    for (uint64_t i = 0; i < 400; i++)
+    {
+        Mempool::AddResult result = pool.add(makeTx(i, int(1000 + (i * 7919) % 5000), {}, 200));
+        assert(result == Mempool::ADDED || result == Mempool::FEE_TOO_LOW);
+        assert(pool.memoryUsage() <= limits.maxMemory);
+    }
+    assert(pool.size() > 50 && pool.size() < 400);
+
+    // What survived beats what was dropped
+    double floor = pool.minFeeRate();
+    Mempool::Template all = pool.selectTemplate(UINT64_MAX);
+    assert(all.transactions.size() == pool.size());
+    for (const auto &tx : all.transactions)
+        assert(double(tx.fee) / tx.serializedSize() >= floor);
+
+    Transaction cheap = makeTx(5000, 1, {}, 200);
+    assert(pool.add(cheap) == Mempool::FEE_TOO_LOW);
+    assert(!pool.contains(cheap.txid));
+
+    // Evicting a parent takes its children
+    Transaction parent = makeTx(6000, 1, {}, 200);
+    Mempool loose(limits);
+    assert(loose.add(parent) == Mempool::ADDED);
+    assert(loose.add(makeTx(6002, 100000, {6000})) == Mempool::ADDED);
+    assert(loose.remove(parent.txid) == 2 && loose.empty() && loose.memoryUsage() == 0);
+}
+
+void test_removeForBlock()
+{
+    Mempool pool;
+    Transaction a = makeTx(1, 100, {});
+    Transaction b = makeTx(2, 100, {1});
+    Transaction c = makeTx(3, 100, {});
+    Transaction d = makeTx(4, 100, {3});
+    for (const Transaction *tx : {&a, &b, &c, &d})
+        pool.add(*tx);
+
+    // Confirms a; a different spend of c's input conflicts with c and d
+    Transaction rival(5, 9, 0, 0, 0, {tin_blockchain::Input(tin_blockchain::PrevOut(1, 1000003, "confirmed", 0))}, {tin_blockchain::Output(1, 9, "")});
+    tin_blockchain::Block block(tin_blockchain::BlockHeader("", "", 0, 1), {a, rival});
+    pool.removeForBlock(block);
+
+    assert(pool.size() == 1 && pool.contains(b.txid));
+    assert(pool.ancestors(b.txid).count == 1 && pool.ancestors(b.txid).fee == 100);
+}
+
+// Package totals against a brute-force walk after random adds and removals
+void test_randomConsistency()
+{
+    Mempool pool;
+    std::map<uint64_t, Transaction> present;
+    std::map<uint64_t, std::vector<uint64_t>> parentsOf;
+    uint32_t seed = 11;
+    uint64_t next = 1;
+
+    for (int step = 0; step < 3000; step++)
+    {
+        seed = seed * 1103515245 + 12345;
+        if ((seed >> 16) % 4 != 0 || present.empty())
+        {
+            std::vector<uint64_t> parents;
+            if (!present.empty() && (seed >> 8) % 2)
+            {
+                auto it = present.begin();
+                std::advance(it, (seed >> 4) % present.size());
+                parents.push_back(it->first);
+            }
+            // Each parent output is spent once, so give each tx many outputs
+            std::vector<tin_blockchain::Input> inputs;
+            for (uint64_t p : parents)
+                inputs.emplace_back(tin_blockchain::PrevOut(1, p, "x", uint32_t(next % 1000)));
+            if (parents.empty())
+                inputs.emplace_back(tin_blockchain::PrevOut(1, 1000000 + next, "confirmed", 0));
+            Transaction tx(int((seed >> 3) % 5000), next, 0, 0, 0, inputs, {tin_blockchain::Output(1, next, "")});
+            if (pool.add(tx) == Mempool::ADDED)
+            {
+                present.emplace(next, tx);
+                parentsOf[next] = parents;
+            }
+            next++;
+        }
+        else
+        {
+            auto it = present.begin();
+            std::advance(it, (seed >> 4) % present.size());
+            pool.remove(it->second.txid);
+            for (auto p = present.begin(); p != present.end();)
+                p = pool.contains(p->second.txid) ? std::next(p) : present.erase(p);
+        }
+    }
+
+    assert(pool.size() == present.size());
+    for (const auto &item : present)
+    {
+        // Ancestors by walking parents
+        std::set<uint64_t> seen;
+        std::vector<uint64_t> pending{item.first};
+        while (!pending.empty())
+        {
+            uint64_t id = pending.back();
+            pending.pop_back();
+            if (!seen.insert(id).second)
+                continue;
+            for (uint64_t p : parentsOf[id])
+                if (present.count(p))
+                    pending.push_back(p);
+        }
+        int64_t fee = 0;
+        for (uint64_t id : seen)
+            fee += present.at(id).fee;
+        Mempool::Package package = pool.ancestors(item.second.txid);
+        assert(package.count == seen.size() && package.fee == fee);
+    }
+}
+
+int main()
+{
+    test_packages();
+    test_limits();
+    test_template();
+    test_eviction();
+    test_removeForBlock();
+    test_randomConsistency();
+
+    std::cout << "All mempool tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "../merkleTree.hpp"
+#include "../merkleAccumulator.hpp"
+#include "../merkleBatchVerifier.hpp"
+#include <cassert>
+#include <iostream>
+
+static std::vector<SHAHash> makeLeaves(size_t count)
+{
+    std::vector<SHAHash> leaves;
+    for (size_t i = 0; i < count; i++)
+    {
+        leaves.push_back(sha256(std::vector<uint8_t>{uint8_t(i), uint8_t(i >> 8), uint8_t(i >> 16)}));
+    }
+    return leaves;
+}
+
+// Straightforward level-by-level reduction, duplicating the odd node
+static SHAHash referenceRoot(std::vector<SHAHash> level)
+{
+    while (level.size() > 1)
+    {
+        if (level.size() % 2 != 0)
+            level.push_back(level.back());
+
+        std::vector<SHAHash> next;
+        for (size_t i = 0; i < level.size(); i += 2)
+        {
+            next.push_back(tin_blockchain::MerkleTree::hashPair(level[i], level[i + 1]));
+        }
+        level = next;
+    }
+    return level[0];
+}
+
+void test_rootsAndProofs()
+{
+    tin::ThreadPool pool(4);
+
+    for (size_t count = 1; count <= 40; count++)
+    {
+        std::vector<SHAHash> leaves = makeLeaves(count);
+        tin_blockchain::MerkleTree tree(leaves, pool);
+        SHAHash root = referenceRoot(leaves);
+
+        assert(tree.leafCount() == count);
+        assert(tree.root() == root);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            tin_blockchain::MerkleProof proof = tree.proof(i);
+            assert(proof.siblings.size() == tin_blockchain::MerkleTree::proofLength(count));
+            assert(tin_blockchain::MerkleTree::verify(leaves[i], proof, root));
+
+            // Wrong leaf or wrong position must not verify
+            assert(!tin_blockchain::MerkleTree::verify(leaves[(i + 1) % count], proof, root) || count == 1);
+            if (!proof.siblings.empty())
+            {
+                proof.siblings[0][0] ^= 1;
+                assert(!tin_blockchain::MerkleTree::verify(leaves[i], proof, root));
+            }
+        }
+    }
+}
+
+void test_largeParallel()
+{
+    std::vector<SHAHash> leaves = makeLeaves(100003);
+    tin::ThreadPool pool(4);
+    tin_blockchain::MerkleTree tree(leaves, pool);
+
+    assert(tree.root() == referenceRoot(leaves));
+    assert(tin_blockchain::MerkleTree::verify(leaves[77777], tree.proof(77777), tree.root()));
+    assert(tin_blockchain::MerkleTree::verify(leaves.back(), tree.proof(leaves.size() - 1), tree.root()));
+}
+
+void test_transactions()
+{
+    assert(tin_blockchain::MerkleTree::computeMerkleRoot({}) == "");
+
+    std::vector<tin_blockchain::Transaction> transactions;
+    std::vector<SHAHash> leaves;
+    for (uint64_t i = 0; i < 5; i++)
+    {
+        tin_blockchain::Transaction tx(10, i, 1700000000, 0, 0, {}, {tin_blockchain::Output(1.5, i, "addr")});
+        transactions.push_back(tx);
+        leaves.push_back(SHAHash::fromHex(tx.hash));
+    }
+
+    assert(tin_blockchain::MerkleTree::computeMerkleRoot(transactions) == referenceRoot(leaves).toString());
+    assert(tin_blockchain::MerkleTree::computeMerkleRoot({transactions[0]}) == transactions[0].hash);
+}
+
+void test_accumulator()
+{
+    std::vector<SHAHash> leaves = makeLeaves(300);
+    tin_blockchain::MerkleAccumulator accumulator;
+    assert(accumulator.empty());
+
+    for (size_t i = 0; i < leaves.size(); i++)
+    {
+        accumulator.append(leaves[i]);
+        std::vector<SHAHash> prefix(leaves.begin(), leaves.begin() + i + 1);
+        assert(accumulator.size() == i + 1);
+        assert(accumulator.root() == tin_blockchain::MerkleTree(prefix).root());
+    }
+
+    accumulator.clear();
+    accumulator.append(leaves[7]);
+    assert(accumulator.root() == leaves[7]);
+}
+
+void test_proofSerialization()
+{
+    std::vector<SHAHash> leaves = makeLeaves(13);
+    tin_blockchain::MerkleTree tree(leaves);
+
+    for (size_t i = 0; i < leaves.size(); i++)
+    {
+        std::vector<uint8_t> bytes = tree.proof(i).serialize();
+        assert(bytes.size() == tin_blockchain::MerkleProof::HEADER_SIZE + 4 * 32);
+
+        tin_blockchain::MerkleProof decoded = tin_blockchain::MerkleProof::deserialize(bytes);
+        assert(decoded.index == i && decoded.leafCount == leaves.size());
+        assert(tin_blockchain::MerkleTree::verify(leaves[i], decoded, tree.root()));
+
+        bytes.pop_back();
+        bool threw = false;
+        try
+        {
+            tin_blockchain::MerkleProof::deserialize(bytes);
+        }
+        catch (const std::invalid_argument &)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // A proof from a 14-leaf tree does not pass as the last leaf of a
+    // 13-leaf one: that leaf would have to be paired with itself
+    std::vector<SHAHash> fourteen = makeLeaves(14);
+    tin_blockchain::MerkleTree larger(fourteen);
+    tin_blockchain::MerkleProof forged = larger.proof(12);
+    assert(tin_blockchain::MerkleTree::verify(fourteen[12], forged, larger.root()));
+    forged.leafCount = 13;
+    assert(!tin_blockchain::MerkleTree::verify(fourteen[12], forged, larger.root()));
+    forged.index = 13;
+    assert(!tin_blockchain::MerkleTree::verify(fourteen[13], forged, larger.root()));
+}
+
+void test_batchVerifier()
+{
+    tin::ThreadPool pool(4);
+    std::vector<tin_blockchain::MerkleBatchVerifier::Item> items;
+    std::vector<uint8_t> expected;
+
+    // Several blocks of different sizes, proofs shuffled together
+    for (size_t blockSize : {1, 7, 1000, 4097})
+    {
+        std::vector<SHAHash> leaves = makeLeaves(blockSize);
+        leaves[0][1] = uint8_t(blockSize);
+        tin_blockchain::MerkleTree tree(leaves, pool);
+
+        for (size_t i = 0; i < blockSize; i += 1 + i % 3)
+        {
+            items.push_back({leaves[i], tree.proof(i), tree.root()});
+            expected.push_back(1);
+
+            if (i % 11 == 0)
+            {
+                items.push_back({leaves[(i + 1) % blockSize], tree.proof(i), tree.root()});
+                expected.push_back(blockSize == 1);
+            }
+        }
+    }
+    for (size_t i = 0; i < items.size(); i += 2)
+    {
+        std::swap(items[i], items[items.size() - 1 - i / 2]);
+        std::swap(expected[i], expected[expected.size() - 1 - i / 2]);
+    }
+
+    auto result = tin_blockchain::MerkleBatchVerifier::verify(items, pool);
+    assert(result.valid == expected);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        assert(bool(result.valid[i]) == tin_blockchain::MerkleTree::verify(items[i].txid, items[i].proof, items[i].merkleRoot));
+    }
+    assert(result.hashesShared > result.hashesComputed);
+
+    std::cout << "batch: " << items.size() << " proofs, " << result.validCount << " valid, "
+              << result.hashesComputed << " hashes computed, " << result.hashesShared << " shared, "
+              << result.proofsPerSecond() << " proofs/s" << std::endl;
+}
+
+int main()
+{
+    test_rootsAndProofs();
+    test_largeParallel();
+    test_transactions();
+    test_accumulator();
+    test_proofSerialization();
+    test_batchVerifier();
+
+    std::cout << "All merkle tree tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "../block.hpp"
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+static tin_blockchain::Block makeBlock(const std::string &previousHash, int difficulty)
+{
+    tin_blockchain::BlockHeader header(sha256(previousHash), "", 1700000000, difficulty);
+    return tin_blockchain::Block(header, {});
+}
+
+void test_matchesSequential()
+{
+    for (const char *previous : {"00", "a1", "b2", "c3"})
+    {
+        tin_blockchain::Block sequential = makeBlock(previous, 3);
+        std::string expectedHash = sequential.mine();
+        uint64_t expectedNonce = sequential.header.nonce;
+
+        for (size_t threads : {1, 2, 4, 7})
+        {
+            for (uint64_t rangeSize : {1, 37, 4096})
+            {
+                tin_blockchain::Block block = makeBlock(previous, 3);
+                tin_blockchain::Miner::Options options;
+                options.threads = threads;
+                options.rangeSize = rangeSize;
+
+                auto result = block.mine(options);
+                assert(result.found && !result.cancelled);
+                assert(result.nonce == expectedNonce);
+                assert(result.hash == expectedHash);
+                assert(block.header.nonce == expectedNonce && block.header.hash == expectedHash);
+                assert(result.threads.size() == threads);
+                assert(result.hashes() >= expectedNonce + 1);
+            }
+        }
+    }
+}
+
+void test_nonceRange()
+{
+    tin_blockchain::Block sequential = makeBlock("00", 3);
+    sequential.mine();
+    uint64_t winner = sequential.header.nonce;
+
+    tin_blockchain::Miner::Options options;
+    options.threads = 3;
+    options.rangeSize = 16;
+
+    // Window that stops just short of the winner
+    options.endNonce = winner;
+    auto missed = tin_blockchain::Miner::mine(sequential.header, options);
+    assert(!missed.found && !missed.cancelled);
+    assert(missed.hashes() == winner);
+
+    // Window that starts on it
+    options.startNonce = winner;
+    options.endNonce = winner + 1;
+    auto hit = tin_blockchain::Miner::mine(sequential.header, options);
+    assert(hit.found && hit.nonce == winner && hit.hashes() == 1);
+}
+
+void test_cancellation()
+{
+    // 64 leading hex zeros will never be found
+    tin_blockchain::Block block = makeBlock("00", 64);
+    std::atomic<bool> cancel(false);
+
+    tin_blockchain::Miner::Options options;
+    options.threads = 4;
+    options.cancel = &cancel;
+
+    std::thread canceller([&]()
+                          {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        cancel = true; });
+
+    auto result = block.mine(options);
+    canceller.join();
+
+    assert(result.cancelled && !result.found);
+    assert(block.header.nonce == 0);
+
+    for (size_t i = 0; i < result.threads.size(); i++)
+    {
+        std::cout << "thread " << i << ": " << result.threads[i].hashes << " hashes, "
+                  << result.threads[i].hashesPerSecond() << " hashes/s" << std::endl;
+    }
+}
+
+int main()
+{
+    test_matchesSequential();
+    test_nonceRange();
+    test_cancellation();
+
+    std::cout << "All miner tests passed" << std::endl;
+    return 0;
+}
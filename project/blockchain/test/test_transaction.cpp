@@ -0,0 +1,165 @@
+#include "../transaction.hpp"
+#include <cassert>
+#include <iostream>
+#include <limits>
+
+static tin_blockchain::Transaction makeTransaction()
+{
+    std::vector<tin_blockchain::Input> inputs = {
+        tin_blockchain::Input(tin_blockchain::PrevOut(4.92e6, 40031577549905, "1GLctvTi81GDYZF5F6nif2MdbxUnAGHATZ", 1))};
+    std::vector<tin_blockchain::Output> out = {
+        tin_blockchain::Output(3.744e6, 6017350324759491, "1AG24pctoCpEMfSvEKfUZqaGYnz8ey8BfF"),
+        tin_blockchain::Output(1.01892e6, 6017350324759491, "")};
+    return tin_blockchain::Transaction(157080, 6017350324759491, 1500839760, 477230, -1, inputs, out);
+}
+
+static bool throwsInvalid(const std::vector<uint8_t> &bytes)
+{
+    try
+    {
+        tin_blockchain::Transaction::deserialize(bytes.data(), bytes.size());
+    }
+    catch (const std::invalid_argument &)
+    {
+        return true;
+    }
+    return false;
+}
+
+void test_varints()
+{
+    using namespace tin_blockchain::encoding;
+
+    for (uint64_t value : {uint64_t(0), uint64_t(1), uint64_t(127), uint64_t(128), uint64_t(300), uint64_t(1) << 35,
+                           std::numeric_limits<uint64_t>::max()})
+    {
+        uint8_t buffer[10];
+        Writer writer(buffer);
+        writer.varint(value);
+        assert(size_t(writer.position() - buffer) == varintSize(value));
+
+        Reader reader(buffer, varintSize(value));
+        assert(reader.varint() == value && reader.remaining() == 0);
+    }
+
+    for (int64_t value : {int64_t(0), int64_t(-1), int64_t(1), int64_t(-64), std::numeric_limits<int64_t>::min(),
+                          std::numeric_limits<int64_t>::max()})
+    {
+        assert(unzigzag(zigzag(value)) == value);
+    }
+    assert(zigzag(-1) == 1 && zigzag(1) == 2);
+
+    // Non-minimal and overlong forms are rejected
+    const uint8_t padded[] = {0x80, 0x00};
+    const uint8_t overlong[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x02};
+    for (auto bytes : {std::make_pair(padded, sizeof(padded)), std::make_pair(overlong, sizeof(overlong))})
+    {
+        bool threw = false;
+        try
+        {
+            Reader(bytes.first, bytes.second).varint();
+        }
+        catch (const std::invalid_argument &)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+}
+
+void test_roundTrip()
+{
+    tin_blockchain::Transaction tx = makeTransaction();
+    std::vector<uint8_t> bytes = tx.serialize();
+    assert(bytes.size() == tx.serializedSize());
+
+    tin_blockchain::Transaction decoded = tin_blockchain::Transaction::deserialize(bytes.data(), bytes.size());
+    assert(decoded.serialize() == bytes);
+    assert(decoded.txid == tx.txid && decoded.hash == tx.hash);
+    assert(decoded.fee == 157080 && decoded.blockHeight == -1 && decoded.time == 1500839760);
+    assert(decoded.inputs.size() == 1 && decoded.inputs[0].prev_out.addr == "1GLctvTi81GDYZF5F6nif2MdbxUnAGHATZ");
+    assert(decoded.inputs[0].prev_out.value == 4.92e6 && decoded.inputs[0].prev_out.n == 1);
+    assert(decoded.out.size() == 2 && decoded.out[1].addr.empty() && decoded.out[1].value == 1.01892e6);
+}
+
+void test_txid()
+{
+    // Known answer: two independent SHA256 passes over {1, 2, 3, 4, 5}
+    std::vector<uint8_t> bytes = {1, 2, 3, 4, 5};
+    assert(double_sha256(bytes).toString() == "a26baf5a9a07d9eb7ba10f43924dcdf3f75f0abf066cd9f0c76f983121302e01");
+
+    tin_blockchain::Transaction tx = makeTransaction();
+    std::vector<uint8_t> encoded = tx.serialize();
+    tin::SHA256 first;
+    first.update(encoded);
+    tin::SHA256 second;
+    second.update(first.digest());
+    assert(tx.txid == SHAHash(second.digest()));
+    assert(tx.hash == tx.txid.toString());
+
+    SHAHash before = tx.txid;
+    tx.out[0].value += 1;
+    assert(tx.txid == before);
+    tx.createHash();
+    assert(tx.txid != before);
+}
+
+void test_malformed()
+{
+    std::vector<uint8_t> bytes = makeTransaction().serialize();
+
+    for (size_t length = 0; length < bytes.size(); length++)
+    {
+        assert(throwsInvalid(std::vector<uint8_t>(bytes.begin(), bytes.begin() + length)));
+    }
+
+    std::vector<uint8_t> trailing = bytes;
+    trailing.push_back(0);
+    assert(throwsInvalid(trailing));
+
+    // Input count far beyond the buffer
+    tin_blockchain::Transaction empty(0, 0, 0, 0, 0, {}, {});
+    assert(empty.serialize() == std::vector<uint8_t>({0, 0, 0, 0, 0, 0, 0}));
+    assert(throwsInvalid({0, 0, 0, 0, 0, 0xff, 0xff, 0xff, 0xff, 0x0f, 0}));
+}
+
+// Well-framed fields too wide for the struct would decode to a different txid
+void test_outOfRange()
+{
+    auto encode = [](int64_t fee, uint64_t time, int64_t blockIndex, int64_t blockHeight)
+    {
+        std::vector<uint8_t> bytes(64);
+        tin_blockchain::encoding::Writer writer(bytes.data());
+        writer.signedVarint(fee);
+        writer.varint(0);
+        writer.varint(time);
+        writer.signedVarint(blockIndex);
+        writer.signedVarint(blockHeight);
+        writer.varint(0);
+        writer.varint(0);
+        bytes.resize(writer.position() - bytes.data());
+        return bytes;
+    };
+
+    std::vector<uint8_t> limits = encode(INT32_MIN, UINT32_MAX, INT32_MAX, INT32_MIN);
+    tin_blockchain::Transaction tx = tin_blockchain::Transaction::deserialize(limits.data(), limits.size());
+    assert(tx.fee == INT32_MIN && tx.time == UINT32_MAX && tx.serialize() == limits);
+
+    assert(throwsInvalid(encode(int64_t(1) << 32 | 5, 0, 0, 0)));
+    assert(throwsInvalid(encode(int64_t(INT32_MIN) - 1, 0, 0, 0)));
+    assert(throwsInvalid(encode(0, uint64_t(UINT32_MAX) + 1, 0, 0)));
+    assert(throwsInvalid(encode(0, 0, int64_t(INT32_MAX) + 1, 0)));
+    assert(throwsInvalid(encode(0, 0, 0, -(int64_t(1) << 40))));
+}
+
+int main()
+{
+    test_varints();
+    test_roundTrip();
+    test_txid();
+    test_malformed();
+    test_outOfRange();
+
+    std::cout << "All transaction tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "../utxoSet.hpp"
+#include <cassert>
+#include <map>
+#include <iostream>
+
+using tin_blockchain::Coin;
+using tin_blockchain::OutPoint;
+using tin_blockchain::UtxoSet;
+
+typedef std::map<std::pair<uint64_t, uint32_t>, std::pair<double, std::string>> Reference;
+
+static void checkAgainst(const UtxoSet &set, const Reference &reference, const std::vector<OutPoint> &probes)
+{
+    assert(set.size() == reference.size());
+    for (const OutPoint &p : probes)
+    {
+        Coin coin;
+        auto it = reference.find({p.txIndex, p.n});
+        bool found = set.find(p, coin);
+        assert(found == (it != reference.end()));
+        if (found)
+        {
+            assert(coin.value == it->second.first);
+            assert(set.address(coin.addr) == it->second.second);
+        }
+    }
+}
+
+void test_randomOperations()
+{
+    UtxoSet set;
+    Reference reference;
+    std::vector<OutPoint> probes;
+
+    // Sequential txIndex values and clustered deletions stress probe runs
+    uint32_t seed = 7;
+    for (int step = 0; step < 200000; step++)
+    {
+        seed = seed * 1103515245 + 12345;
+        OutPoint p{(seed >> 8) % 5000, (seed >> 4) % 4};
+        std::string addr = "addr" + std::to_string(p.txIndex % 97);
+
+        if ((seed >> 20) % 3 != 0)
+        {
+            bool added = set.add(p, double(step), addr);
+            bool expected = reference.emplace(std::make_pair(p.txIndex, p.n), std::make_pair(double(step), addr)).second;
+            assert(added == expected);
+        }
+        else
+        {
+            assert(set.spend(p) == (reference.erase({p.txIndex, p.n}) == 1));
+        }
+
+        if (step % 1000 == 0)
+            probes.push_back(p);
+    }
+
+    for (uint64_t tx = 0; tx < 5000; tx += 13)
+        for (uint32_t n = 0; n < 4; n++)
+            probes.push_back(OutPoint{tx, n});
+    checkAgainst(set, reference, probes);
+}
+
+static tin_blockchain::Transaction makeTx(uint64_t txIndex, std::vector<tin_blockchain::PrevOut> spends, size_t outputs)
+{
+    std::vector<tin_blockchain::Input> inputs(spends.begin(), spends.end());
+    std::vector<tin_blockchain::Output> out;
+    for (size_t n = 0; n < outputs; n++)
+        out.emplace_back(double(txIndex * 10 + n), txIndex, "a" + std::to_string(txIndex));
+    return tin_blockchain::Transaction(0, txIndex, 0, 0, 0, inputs, out);
+}
+
+static tin_blockchain::Block makeBlock(std::vector<tin_blockchain::Transaction> transactions)
+{
+    return tin_blockchain::Block(tin_blockchain::BlockHeader("", "", 0, 1), transactions);
+}
+
+void test_applyAndUndo()
+{
+    UtxoSet set;
+    std::vector<UtxoSet::BlockUndo> undos(3);
+
+    set.apply(makeBlock({makeTx(1, {}, 3), makeTx(2, {}, 2)}), undos[0]);
+    assert(set.size() == 5);
+
+    // Spends from an earlier block and from earlier in the same block
+    set.apply(makeBlock({makeTx(3, {tin_blockchain::PrevOut(10, 1, "a1", 0), tin_blockchain::PrevOut(21, 2, "a2", 1)}, 1),
+                         makeTx(4, {tin_blockchain::PrevOut(30, 3, "a3", 0)}, 2)}),
+              undos[1]);
+    assert(set.size() == 5);
+    assert(!set.contains(OutPoint{1, 0}) && !set.contains(OutPoint{3, 0}));
+    Coin coin;
+    assert(set.find(OutPoint{4, 1}, coin) && coin.value == 41 && set.address(coin.addr) == "a4");
+    assert(undos[1].changes.size() == 6);
+
+    // Double spend: the whole block is rejected and nothing changes
+    bool threw = false;
+    try
+    {
+        set.apply(makeBlock({makeTx(5, {tin_blockchain::PrevOut(11, 1, "a1", 1)}, 1),
+                             makeTx(6, {tin_blockchain::PrevOut(11, 1, "a1", 1)}, 1)}),
+                  undos[2]);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+    assert(set.size() == 5 && set.contains(OutPoint{1, 1}) && !set.contains(OutPoint{5, 0}));
+
+    set.undo(undos[1]);
+    assert(set.size() == 5);
+    for (uint32_t n = 0; n < 3; n++)
+        assert(set.find(OutPoint{1, n}, coin) && coin.value == 10 + n);
+    assert(set.contains(OutPoint{2, 1}) && !set.contains(OutPoint{4, 0}));
+
+    set.undo(undos[0]);
+    assert(set.empty());
+}
+
+void test_memoryPerEntry()
+{
+    const size_t ENTRIES = 1 << 20;
+    UtxoSet set(ENTRIES);
+    size_t capacity = set.capacity();
+
+    for (uint64_t i = 0; i < ENTRIES; i++)
+    {
+        set.add(OutPoint{i / 2, uint32_t(i % 2)}, 1.0, "1BoatSLRHtKNngkdXEeobR76b53LETtpyT" + std::to_string(i % 1000));
+    }
+    assert(set.capacity() == capacity);
+    assert(set.bytesPerEntry() < 3 * UtxoSet::SLOT_SIZE);
+    std::cout << "UTXO set: " << set.size() << " entries, " << set.bytesPerEntry() << " bytes per entry" << std::endl;
+}
+
+int main()
+{
+    test_randomOperations();
+    test_applyAndUndo();
+    test_memoryPerEntry();
+
+    std::cout << "All UTXO set tests passed" << std::endl;
+    return 0;
+}
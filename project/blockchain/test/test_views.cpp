@@ -0,0 +1,140 @@
+#include "../blockView.hpp"
+#include "../mappedFile.hpp"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+static tin_blockchain::Block makeBlock()
+{
+    std::vector<tin_blockchain::Transaction> transactions;
+    for (uint64_t i = 0; i < 5; i++)
+    {
+        std::vector<tin_blockchain::Input> inputs;
+        for (uint64_t j = 0; j < i; j++)
+        {
+            inputs.emplace_back(tin_blockchain::PrevOut(1000.0 * j, i * 100 + j, "prev" + std::to_string(j), uint32_t(j * 300)));
+        }
+        std::vector<tin_blockchain::Output> out = {
+            tin_blockchain::Output(2.5e6, i, "addr" + std::to_string(i)),
+            tin_blockchain::Output(0.5, i, "")};
+        transactions.emplace_back(int(i) * 10 - 20, 1000 + i, 1700000000 + i, 7, 8, inputs, out);
+    }
+
+    tin_blockchain::BlockHeader header(sha256(std::string("parent")), tin_blockchain::MerkleTree::computeMerkleRoot(transactions), 1700000000, 1);
+    tin_blockchain::Block block(header, transactions);
+    block.mine();
+    return block;
+}
+
+void test_blockView()
+{
+    tin_blockchain::Block block = makeBlock();
+    std::vector<uint8_t> bytes = block.serialize();
+    tin_blockchain::BlockView view(bytes.data(), bytes.size());
+
+    assert(view.byteSize() == bytes.size());
+    assert(view.hash().toString() == block.header.hash);
+    assert(view.previousHash().toString() == block.header.previousHash);
+    assert(view.merkleRoot().toString() == block.header.merkleRoot);
+    assert(view.timestamp() == 1700000000 && view.difficulty() == 1 && view.nonce() == block.header.nonce);
+    assert(view.size() == block.transactions.size());
+
+    size_t index = 0;
+    for (tin_blockchain::TransactionView tx : view.transactions())
+    {
+        const tin_blockchain::Transaction &expected = block.transactions[index++];
+        assert(tx.txid() == expected.txid);
+        assert(tx.fee() == expected.fee && tx.txIndex() == expected.txIndex && tx.time() == expected.time);
+        assert(tx.inputs().size() == expected.inputs.size() && tx.outputs().size() == 2);
+
+        // Strings point into the serialized buffer
+        tin_blockchain::OutputView first = *tx.outputs().begin();
+        assert(first.addr() == expected.out[0].addr);
+        assert(first.addr().data() >= reinterpret_cast<const char *>(bytes.data()) &&
+               first.addr().data() < reinterpret_cast<const char *>(bytes.data() + bytes.size()));
+
+        size_t j = 0;
+        for (const auto &input : tx.inputs())
+        {
+            assert(input.prevOut().value() == expected.inputs[j].prev_out.value);
+            assert(input.prevOut().addr() == expected.inputs[j].prev_out.addr);
+            assert(input.prevOut().n() == expected.inputs[j].prev_out.n);
+            j++;
+        }
+        assert(j == expected.inputs.size());
+        assert(tx.materialize().txid == expected.txid);
+    }
+    assert(index == block.transactions.size());
+
+    tin_blockchain::Block copy = view.materialize();
+    assert(copy.serialize() == bytes);
+    assert(tin_blockchain::Block::deserialize(bytes.data(), bytes.size()).serialize() == bytes);
+}
+
+void test_malformed()
+{
+    std::vector<uint8_t> bytes = makeBlock().serialize();
+    for (size_t length : {size_t(0), size_t(79), size_t(80), bytes.size() / 2, bytes.size() - 1})
+    {
+        bool threw = false;
+        try
+        {
+            tin_blockchain::BlockView(bytes.data(), length);
+        }
+        catch (const std::invalid_argument &)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // A fee of 2^32 + 5 is well framed but would materialize as 5
+    std::vector<uint8_t> wide(16);
+    tin_blockchain::encoding::Writer writer(wide.data());
+    writer.signedVarint((int64_t(1) << 32) + 5);
+    for (int i = 0; i < 6; i++)
+        writer.varint(0);
+    wide.resize(writer.position() - wide.data());
+    bool threw = false;
+    try
+    {
+        tin_blockchain::TransactionView(wide.data(), wide.size());
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_mappedFile()
+{
+    const std::string path = "views_test.tmp";
+    tin_blockchain::Block block = makeBlock();
+    std::vector<uint8_t> bytes = block.serialize();
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+
+    {
+        tin_blockchain::MappedFile file(path);
+        tin_blockchain::BlockView view(file.data(), file.size());
+        assert(view.hash().toString() == block.header.hash);
+
+        uint64_t outputs = 0;
+        for (const auto &tx : view.transactions())
+            outputs += tx.outputs().size();
+        assert(outputs == 10);
+    }
+
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    test_blockView();
+    test_malformed();
+    test_mappedFile();
+
+    std::cout << "All view tests passed" << std::endl;
+    return 0;
+}
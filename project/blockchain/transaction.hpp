@@ -9,6 +9,8 @@
 #include "input.hpp"
 #include "output.hpp"
 #include "sha.hpp"
+#include "encoding.hpp"
+#include "jsonWriter.hpp"
 
 /**
  * @todo complete all variable in Transaction
@@ -17,9 +19,19 @@
  */
 namespace tin_blockchain
 {
+    /**
+     * Wire format (see encoding.hpp for the primitives):
+     *
+     *   fee (zigzag) | txIndex | time | blockIndex (zigzag) | blockHeight (zigzag)
+     *   | input count | inputs... | output count | outputs...
+     *
+     * The txid is the double SHA256 of that encoding. It is computed once,
+     * when the transaction is built, and kept both raw (txid) and as hex (hash).
+     */
     class Transaction
     {
     public:
+        SHAHash txid;
         std::string hash;
         int fee;
         uint64_t txIndex;
@@ -37,52 +49,139 @@ namespace tin_blockchain
             createHash();
         }
 
+        // Recomputes txid and hash; call again after changing any field
         void createHash()
         {
-            std::string serializedData = serialize();
-            hash = sha256(sha256(serializedData));
+            // Reused between calls so hashing does not allocate once warm
+            thread_local std::vector<uint8_t> buffer;
+            buffer.resize(serializedSize());
+            serialize(buffer.data());
+            txid = sha256d(buffer.data(), buffer.size());
+            hash = txid.toString();
+        }
+
+        template <typename Sink>
+        void writeJson(JsonWriter<Sink> &json) const
+        {
+            json.beginObject()
+                .field("hash", hash)
+                .field("fee", fee)
+                .field("time", time)
+                .field("blockIndex", blockIndex)
+                .field("blockHeight", blockHeight)
+                .key("inputs")
+                .beginArray();
+            for (const auto &in : inputs)
+            {
+                in.writeJson(json);
+            }
+            json.endArray().key("out").beginArray();
+            for (const auto &ou : out)
+            {
+                ou.writeJson(json);
+            }
+            json.endArray().endObject();
         }
 
         std::string toString() const
         {
-            std::ostringstream oss;
-            oss << "{"
-                << "\"hash\": " << std::quoted(hash)
-                << ", \"fee\": " << fee
-                << ", \"time\": " << time
-                << ", \"blockIndex\": " << blockIndex
-                << ", \"blockHeight\": " << blockHeight
-                << ", \"inputs\": [";
-            for (size_t i = 0; i < inputs.size(); ++i)
+            StringSink sink;
+            JsonWriter<StringSink> json(sink);
+            writeJson(json);
+            return sink.str;
+        }
+
+        size_t serializedSize() const
+        {
+            size_t size = encoding::varintSize(encoding::zigzag(fee)) + encoding::varintSize(txIndex) +
+                          encoding::varintSize(time) + encoding::varintSize(encoding::zigzag(blockIndex)) +
+                          encoding::varintSize(encoding::zigzag(blockHeight)) +
+                          encoding::varintSize(inputs.size()) + encoding::varintSize(out.size());
+            for (const auto &in : inputs)
             {
-                oss << inputs[i].toString();
-                if (i < inputs.size() - 1)
-                    oss << ", ";
+                size += in.serializedSize();
             }
-            oss << "], \"out\": [";
-            for (size_t i = 0; i < out.size(); ++i)
+            for (const auto &ou : out)
             {
-                oss << out[i].toString();
-                if (i < out.size() - 1)
-                    oss << ", ";
+                size += ou.serializedSize();
             }
-            oss << "]}";
-            return oss.str();
+            return size;
         }
 
-        std::string serialize() const
+        // Writes serializedSize() bytes to `buffer` and returns the end
+        uint8_t *serialize(uint8_t *buffer) const
         {
-            std::ostringstream oss;
-            oss << fee << txIndex << time << blockIndex << blockHeight;
+            encoding::Writer writer(buffer);
+            serialize(writer);
+            return writer.position();
+        }
+
+        void serialize(encoding::Writer &writer) const
+        {
+            writer.signedVarint(fee);
+            writer.varint(txIndex);
+            writer.varint(time);
+            writer.signedVarint(blockIndex);
+            writer.signedVarint(blockHeight);
+            writer.varint(inputs.size());
             for (const auto &in : inputs)
             {
-                oss << in.serialize();
+                in.serialize(writer);
             }
+            writer.varint(out.size());
             for (const auto &ou : out)
             {
-                oss << ou.serialize();
+                ou.serialize(writer);
+            }
+        }
+
+        std::vector<uint8_t> serialize() const
+        {
+            std::vector<uint8_t> buffer(serializedSize());
+            serialize(buffer.data());
+            return buffer;
+        }
+
+        // Throws std::invalid_argument on malformed input
+        static Transaction deserialize(encoding::Reader &reader)
+        {
+            int fee = encoding::intField(reader.signedVarint(), "fee");
+            uint64_t txIndex = reader.varint();
+            unsigned int time = encoding::unsignedField(reader.varint(), "time");
+            int blockIndex = encoding::intField(reader.signedVarint(), "blockIndex");
+            int blockHeight = encoding::intField(reader.signedVarint(), "blockHeight");
+
+            // Counts are capped by the bytes left before reserving, so a bad
+            // count fails on truncation instead of a huge allocation
+            std::vector<Input> inputs;
+            uint64_t inputCount = reader.varint();
+            inputs.reserve(std::min<uint64_t>(inputCount, reader.remaining()));
+            for (uint64_t i = 0; i < inputCount; i++)
+            {
+                inputs.push_back(Input::deserialize(reader));
+            }
+
+            std::vector<Output> out;
+            uint64_t outputCount = reader.varint();
+            out.reserve(std::min<uint64_t>(outputCount, reader.remaining()));
+            for (uint64_t i = 0; i < outputCount; i++)
+            {
+                out.push_back(Output::deserialize(reader));
+            }
+
+            return Transaction(fee, txIndex, time, blockIndex, blockHeight, inputs, out);
+        }
+
+        // The whole buffer must be exactly one transaction
+        static Transaction deserialize(const uint8_t *data, size_t size)
+        {
+            encoding::Reader reader(data, size);
+            Transaction tx = deserialize(reader);
+            if (reader.remaining() != 0)
+            {
+                throw std::invalid_argument("Trailing bytes after transaction");
             }
-            return oss.str();
+            return tx;
         }
     };
 }
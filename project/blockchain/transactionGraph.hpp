@@ -0,0 +1,102 @@
+#ifndef BLOCKCHAIN_TRANSACTION_GRAPH
+#define BLOCKCHAIN_TRANSACTION_GRAPH
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+#include "transaction.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * The spend graph inside one block: transaction i depends on j when one
+     * of i's inputs names j's txIndex and j comes earlier in the block. An
+     * input naming a later (or the same) transaction is not an edge; it is
+     * simply invalid, as it would be when checking in order.
+     *
+     * Transactions are grouped into waves by depth: wave 0 spends nothing
+     * from the block, wave k only spends from waves below k. Within a wave
+     * transactions are listed in block order. Parents and waves are stored
+     * as flat offset arrays.
+     */
+    class TransactionGraph
+    {
+    public:
+        static const uint32_t NONE = UINT32_MAX;
+
+        explicit TransactionGraph(const std::vector<Transaction> &transactions)
+        {
+            size_t n = transactions.size();
+            positions.reserve(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                positions.emplace(transactions[i].txIndex, uint32_t(i));
+            }
+
+            levels.assign(n, 0);
+            parentStart.assign(n + 1, 0);
+            uint32_t depth = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                size_t first = parentList.size();
+                for (const auto &input : transactions[i].inputs)
+                {
+                    uint32_t j = position(input.prev_out.txIndex);
+                    if (j == NONE || j >= i)
+                        continue;
+                    if (std::find(parentList.begin() + first, parentList.end(), j) == parentList.end())
+                    {
+                        parentList.push_back(j);
+                        levels[i] = std::max(levels[i], levels[j] + 1);
+                    }
+                }
+                parentStart[i + 1] = uint32_t(parentList.size());
+                depth = std::max(depth, levels[i] + 1);
+            }
+
+            // Counting sort by level keeps block order inside each wave
+            waveStart.assign(size_t(depth) + 1, 0);
+            for (uint32_t level : levels)
+                waveStart[level + 1]++;
+            for (size_t k = 0; k < depth; k++)
+                waveStart[k + 1] += waveStart[k];
+            order.resize(n);
+            std::vector<uint32_t> next(waveStart.begin(), waveStart.end() - 1);
+            for (size_t i = 0; i < n; i++)
+                order[next[levels[i]]++] = uint32_t(i);
+        }
+
+        size_t size() const { return levels.size(); }
+
+        // Position of the first transaction with `txIndex`, or NONE
+        uint32_t position(uint64_t txIndex) const
+        {
+            auto it = positions.find(txIndex);
+            return it == positions.end() ? NONE : it->second;
+        }
+
+        uint32_t level(size_t i) const { return levels[i]; }
+
+        const uint32_t *parentsBegin(size_t i) const { return parentList.data() + parentStart[i]; }
+        const uint32_t *parentsEnd(size_t i) const { return parentList.data() + parentStart[i + 1]; }
+
+        size_t waveCount() const { return waveStart.size() - 1; }
+
+        // Positions in wave k, ascending
+        const uint32_t *waveBegin(size_t k) const { return order.data() + waveStart[k]; }
+        const uint32_t *waveEnd(size_t k) const { return order.data() + waveStart[k + 1]; }
+        size_t waveSize(size_t k) const { return waveStart[k + 1] - waveStart[k]; }
+
+    private:
+        std::unordered_map<uint64_t, uint32_t> positions;
+        std::vector<uint32_t> levels;
+        std::vector<uint32_t> parentStart;
+        std::vector<uint32_t> parentList;
+        std::vector<uint32_t> waveStart;
+        std::vector<uint32_t> order;
+    };
+}
+
+#endif
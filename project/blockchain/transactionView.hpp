@@ -0,0 +1,259 @@
+#ifndef BLOCKCHAIN_TRANSACTION_VIEW
+#define BLOCKCHAIN_TRANSACTION_VIEW
+
+#include <string>
+#include <string_view>
+#include <iterator>
+#include <cstdint>
+
+#include "encoding.hpp"
+#include "transaction.hpp"
+
+namespace tin_blockchain
+{
+    /**
+     * Read-only views over the binary wire format (see transaction.hpp). A
+     * view points into the caller's buffer (or an mmap'd file) and copies
+     * nothing: integers are decoded on construction and strings come back as
+     * string_view into the buffer, so the buffer must outlive its views.
+     *
+     * Inputs and outputs are walked lazily through ViewRange, which decodes
+     * one element per step.
+     */
+
+    // Forward range over `count` consecutive encoded elements of type T
+    template <typename T>
+    class ViewRange
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T *;
+            using reference = T;
+
+            iterator(const uint8_t *position, const uint8_t *end, uint64_t remaining)
+                : reader(position, end - position), remaining(remaining)
+            {
+                if (remaining > 0)
+                    current = T::parse(reader);
+            }
+
+            // By value: views are small, and this stays valid after the
+            // iterator moves on
+            T operator*() const { return current; }
+            const T *operator->() const { return &current; }
+
+            iterator &operator++()
+            {
+                if (--remaining > 0)
+                    current = T::parse(reader);
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const { return remaining == other.remaining; }
+            bool operator!=(const iterator &other) const { return remaining != other.remaining; }
+
+        private:
+            encoding::Reader reader;
+            uint64_t remaining;
+            T current;
+        };
+
+        ViewRange(const uint8_t *begin, const uint8_t *end, uint64_t count) : first(begin), last(end), count(count) {}
+
+        iterator begin() const { return iterator(first, last, count); }
+        iterator end() const { return iterator(last, last, 0); }
+        uint64_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+    private:
+        const uint8_t *first;
+        const uint8_t *last;
+        uint64_t count;
+    };
+
+    namespace view_detail
+    {
+        inline std::string_view readString(encoding::Reader &reader)
+        {
+            size_t length;
+            const char *data = reader.string(length);
+            return std::string_view(data, length);
+        }
+    }
+
+    class OutputView
+    {
+    public:
+        OutputView() {}
+
+        static OutputView parse(encoding::Reader &reader)
+        {
+            OutputView view;
+            view.valueField = reader.float64();
+            view.txIndexField = reader.varint();
+            view.addrField = view_detail::readString(reader);
+            return view;
+        }
+
+        double value() const { return valueField; }
+        uint64_t txIndex() const { return txIndexField; }
+        std::string_view addr() const { return addrField; }
+
+        Output materialize() const { return Output(valueField, txIndexField, std::string(addrField)); }
+
+    private:
+        double valueField = 0;
+        uint64_t txIndexField = 0;
+        std::string_view addrField;
+    };
+
+    class PrevOutView
+    {
+    public:
+        PrevOutView() {}
+
+        static PrevOutView parse(encoding::Reader &reader)
+        {
+            PrevOutView view;
+            view.valueField = reader.float64();
+            view.txIndexField = reader.varint();
+            uint64_t n = reader.varint();
+            if (n > UINT32_MAX)
+                throw std::invalid_argument("Output index out of range");
+            view.nField = uint32_t(n);
+            view.addrField = view_detail::readString(reader);
+            return view;
+        }
+
+        double value() const { return valueField; }
+        uint64_t txIndex() const { return txIndexField; }
+        uint32_t n() const { return nField; }
+        std::string_view addr() const { return addrField; }
+
+        PrevOut materialize() const { return PrevOut(valueField, txIndexField, std::string(addrField), nField); }
+
+    private:
+        double valueField = 0;
+        uint64_t txIndexField = 0;
+        uint32_t nField = 0;
+        std::string_view addrField;
+    };
+
+    class InputView
+    {
+    public:
+        InputView() {}
+
+        static InputView parse(encoding::Reader &reader)
+        {
+            InputView view;
+            view.prevOutField = PrevOutView::parse(reader);
+            return view;
+        }
+
+        const PrevOutView &prevOut() const { return prevOutField; }
+
+        Input materialize() const { return Input(prevOutField.materialize()); }
+
+    private:
+        PrevOutView prevOutField;
+    };
+
+    class TransactionView
+    {
+    public:
+        TransactionView() {}
+
+        // The whole buffer must be exactly one transaction; throws
+        // std::invalid_argument otherwise
+        TransactionView(const uint8_t *data, size_t size)
+        {
+            encoding::Reader reader(data, size);
+            *this = parse(reader);
+            if (reader.remaining() != 0)
+                throw std::invalid_argument("Trailing bytes after transaction");
+        }
+
+        // Decodes the fixed fields and skips over inputs and outputs to find
+        // where the transaction ends. Fields are range-checked as in
+        // Transaction::deserialize(), so a view exists only for bytes that
+        // materialize() reproduces exactly.
+        static TransactionView parse(encoding::Reader &reader)
+        {
+            TransactionView view;
+            view.begin = reader.position();
+            view.feeField = encoding::intField(reader.signedVarint(), "fee");
+            view.txIndexField = reader.varint();
+            view.timeField = encoding::unsignedField(reader.varint(), "time");
+            view.blockIndexField = encoding::intField(reader.signedVarint(), "blockIndex");
+            view.blockHeightField = encoding::intField(reader.signedVarint(), "blockHeight");
+
+            view.inputCount = reader.varint();
+            view.inputsBegin = reader.position();
+            for (uint64_t i = 0; i < view.inputCount; i++)
+                InputView::parse(reader);
+
+            view.outputCount = reader.varint();
+            view.outputsBegin = reader.position();
+            for (uint64_t i = 0; i < view.outputCount; i++)
+                OutputView::parse(reader);
+
+            view.end = reader.position();
+            return view;
+        }
+
+        int64_t fee() const { return feeField; }
+        uint64_t txIndex() const { return txIndexField; }
+        uint64_t time() const { return timeField; }
+        int64_t blockIndex() const { return blockIndexField; }
+        int64_t blockHeight() const { return blockHeightField; }
+
+        ViewRange<InputView> inputs() const { return ViewRange<InputView>(inputsBegin, outputsBegin, inputCount); }
+        ViewRange<OutputView> outputs() const { return ViewRange<OutputView>(outputsBegin, end, outputCount); }
+
+        // Encoded bytes of this transaction inside the buffer
+        const uint8_t *data() const { return begin; }
+        size_t size() const { return end - begin; }
+
+        // Hash of the bytes in place. The encoding is canonical and parse()
+        // rejects out-of-range fields, so this equals Transaction::txid of
+        // the materialized transaction.
+        SHAHash txid() const
+        {
+            return sha256d(begin, size());
+        }
+
+        Transaction materialize() const
+        {
+            std::vector<Input> in;
+            std::vector<Output> out;
+            in.reserve(inputCount);
+            out.reserve(outputCount);
+            for (const auto &input : inputs())
+                in.push_back(input.materialize());
+            for (const auto &output : outputs())
+                out.push_back(output.materialize());
+            return Transaction(int(feeField), txIndexField, (unsigned int)timeField, int(blockIndexField), int(blockHeightField), in, out);
+        }
+
+    private:
+        const uint8_t *begin = nullptr;
+        const uint8_t *inputsBegin = nullptr;
+        const uint8_t *outputsBegin = nullptr;
+        const uint8_t *end = nullptr;
+        int64_t feeField = 0;
+        uint64_t txIndexField = 0;
+        uint64_t timeField = 0;
+        int64_t blockIndexField = 0;
+        int64_t blockHeightField = 0;
+        uint64_t inputCount = 0;
+        uint64_t outputCount = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,344 @@
+#ifndef BLOCKCHAIN_UTXO_SET
+#define BLOCKCHAIN_UTXO_SET
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "block.hpp"
+
+namespace tin_blockchain
+{
+    // An output, named the way inputs name it: PrevOut::txIndex and PrevOut::n
+    struct OutPoint
+    {
+        uint64_t txIndex;
+        uint32_t n;
+
+        static OutPoint of(const PrevOut &prevOut) { return OutPoint{prevOut.txIndex, prevOut.n}; }
+
+        bool operator==(const OutPoint &other) const { return txIndex == other.txIndex && n == other.n; }
+        bool operator!=(const OutPoint &other) const { return !(*this == other); }
+    };
+
+    // An unspent output's payload; `addr` is a handle into the set's AddressTable
+    struct Coin
+    {
+        double value;
+        uint32_t addr;
+    };
+
+    /**
+     * Interned addresses. The characters live in one arena and an
+     * open-addressing table of ids finds them, so each distinct address is
+     * stored once however many outputs pay it. Handles are never reused.
+     */
+    class AddressTable
+    {
+    public:
+        AddressTable() : slots(16, 0) {}
+
+        uint32_t intern(std::string_view addr)
+        {
+            size_t mask = slots.size() - 1;
+            for (size_t i = hash(addr) & mask;; i = (i + 1) & mask)
+            {
+                if (slots[i] == 0)
+                {
+                    uint32_t id = uint32_t(offsets.size() - 1);
+                    chars.append(addr.data(), addr.size());
+                    offsets.push_back(uint32_t(chars.size()));
+                    slots[i] = id + 1;
+                    if ((offsets.size() - 1) * 4 > slots.size() * 3)
+                        grow();
+                    return id;
+                }
+                if (get(slots[i] - 1) == addr)
+                    return slots[i] - 1;
+            }
+        }
+
+        std::string_view get(uint32_t id) const
+        {
+            return std::string_view(chars.data() + offsets[id], offsets[id + 1] - offsets[id]);
+        }
+
+        size_t size() const { return offsets.size() - 1; }
+
+        size_t memoryUsage() const
+        {
+            return chars.capacity() + offsets.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(uint32_t);
+        }
+
+    private:
+        std::string chars;
+        std::vector<uint32_t> offsets = {0};
+        // id + 1, or 0 for an empty slot
+        std::vector<uint32_t> slots;
+
+        static size_t hash(std::string_view addr) { return std::hash<std::string_view>()(addr); }
+
+        void grow()
+        {
+            std::vector<uint32_t> bigger(slots.size() * 2, 0);
+            size_t mask = bigger.size() - 1;
+            for (uint32_t id = 0; id < size(); id++)
+            {
+                size_t i = hash(get(id)) & mask;
+                while (bigger[i] != 0)
+                    i = (i + 1) & mask;
+                bigger[i] = id + 1;
+            }
+            slots.swap(bigger);
+        }
+    };
+
+    /**
+     * The unspent outputs, in one flat open-addressing table of 24-byte
+     * slots (txIndex, n, address handle, value) with linear probing and
+     * backward-shift deletion, so there are no tombstones and no per-entry
+     * allocations. The table doubles at 75% load.
+     *
+     * apply() spends and creates a whole block's outputs and records what it
+     * did in a BlockUndo; undo() reverses it exactly. A block that spends a
+     * missing output leaves the set unchanged.
+     */
+    class UtxoSet
+    {
+    public:
+        // One spend or creation; `coin` is what a spend removed
+        struct Change
+        {
+            OutPoint outPoint;
+            Coin coin;
+            bool created;
+        };
+
+        // The block's changes in the order they were made. undo() walks it
+        // backwards, which also handles outputs created and spent within
+        // the block.
+        struct BlockUndo
+        {
+            std::vector<Change> changes;
+        };
+
+        static constexpr size_t SLOT_SIZE = 24;
+
+        explicit UtxoSet(size_t expectedEntries = 0)
+        {
+            size_t capacity = MIN_CAPACITY;
+            while (capacity * 3 < expectedEntries * 4)
+                capacity *= 2;
+            slots.assign(capacity, emptySlot());
+        }
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        size_t capacity() const { return slots.size(); }
+
+        bool contains(const OutPoint &outPoint) const { return findIndex(outPoint) != NOT_FOUND; }
+
+        bool find(const OutPoint &outPoint, Coin &coin) const
+        {
+            size_t i = findIndex(outPoint);
+            if (i == NOT_FOUND)
+                return false;
+            coin = Coin{slots[i].value, slots[i].addr};
+            return true;
+        }
+
+        std::string_view address(uint32_t handle) const { return addresses.get(handle); }
+
+        // False if the output is already unspent
+        bool add(const OutPoint &outPoint, double value, std::string_view addr)
+        {
+            return insert(outPoint, Coin{value, addresses.intern(addr)});
+        }
+
+        // Removes the output; false if it was not unspent
+        bool spend(const OutPoint &outPoint, Coin *coin = nullptr)
+        {
+            size_t i = findIndex(outPoint);
+            if (i == NOT_FOUND)
+                return false;
+            if (coin)
+                *coin = Coin{slots[i].value, slots[i].addr};
+            erase(i);
+            return true;
+        }
+
+        // Spends every input and adds every output of `block`, in
+        // transaction order, so a transaction can spend an earlier one in
+        // the same block. Throws std::invalid_argument, with the set
+        // restored, if an input is not unspent or an output already is.
+        void apply(const Block &block, BlockUndo &undoData)
+        {
+            undoData.changes.clear();
+
+            for (const auto &tx : block.transactions)
+            {
+                for (const auto &in : tx.inputs)
+                {
+                    OutPoint outPoint = OutPoint::of(in.prev_out);
+                    Coin coin;
+                    if (!spend(outPoint, &coin))
+                    {
+                        undo(undoData);
+                        throw std::invalid_argument("Transaction " + tx.hash + " spends a missing output " +
+                                                    std::to_string(outPoint.txIndex) + ":" + std::to_string(outPoint.n));
+                    }
+                    undoData.changes.push_back(Change{outPoint, coin, false});
+                }
+
+                for (uint32_t n = 0; n < tx.out.size(); n++)
+                {
+                    OutPoint outPoint{tx.txIndex, n};
+                    if (!add(outPoint, tx.out[n].value, tx.out[n].addr))
+                    {
+                        undo(undoData);
+                        throw std::invalid_argument("Transaction " + tx.hash + " recreates unspent output " +
+                                                    std::to_string(outPoint.txIndex) + ":" + std::to_string(n));
+                    }
+                    undoData.changes.push_back(Change{outPoint, Coin{0, 0}, true});
+                }
+            }
+        }
+
+        // Reverses an apply(); blocks must be undone newest first
+        void undo(const BlockUndo &undoData)
+        {
+            for (auto it = undoData.changes.rbegin(); it != undoData.changes.rend(); ++it)
+            {
+                bool matched = it->created ? spend(it->outPoint) : insert(it->outPoint, it->coin);
+                if (!matched)
+                    throw std::logic_error("Undo data does not match the UTXO set");
+            }
+        }
+
+        void reserve(size_t entries)
+        {
+            size_t capacity = slots.size();
+            while (capacity * 3 < entries * 4)
+                capacity *= 2;
+            if (capacity != slots.size())
+                rehash(capacity);
+        }
+
+        // Heap bytes held by the table and the address arena
+        size_t memoryUsage() const
+        {
+            return slots.capacity() * sizeof(Slot) + addresses.memoryUsage();
+        }
+
+        // memoryUsage() per unspent output; multiply by the expected output
+        // count to size a node
+        double bytesPerEntry() const
+        {
+            return count == 0 ? 0 : double(memoryUsage()) / count;
+        }
+
+    private:
+        struct Slot
+        {
+            uint64_t txIndex;
+            uint32_t n;
+            uint32_t addr;
+            double value;
+        };
+        static_assert(sizeof(Slot) == SLOT_SIZE, "Slot must stay packed");
+
+        static constexpr size_t MIN_CAPACITY = 64;
+        static constexpr size_t NOT_FOUND = SIZE_MAX;
+        // Output indexes never get this large, so it marks an empty slot
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+
+        std::vector<Slot> slots;
+        size_t count = 0;
+        AddressTable addresses;
+
+        static Slot emptySlot() { return Slot{0, EMPTY, 0, 0}; }
+
+        // txIndex values are sequential, so mix before masking
+        static size_t hash(const OutPoint &outPoint)
+        {
+            uint64_t h = outPoint.txIndex * 0x9e3779b97f4a7c15ULL ^ (uint64_t(outPoint.n) * 0xc2b2ae3d27d4eb4fULL);
+            return size_t(h ^ (h >> 32));
+        }
+
+        size_t findIndex(const OutPoint &outPoint) const
+        {
+            size_t mask = slots.size() - 1;
+            for (size_t i = hash(outPoint) & mask;; i = (i + 1) & mask)
+            {
+                const Slot &slot = slots[i];
+                if (slot.n == EMPTY)
+                    return NOT_FOUND;
+                if (slot.txIndex == outPoint.txIndex && slot.n == outPoint.n)
+                    return i;
+            }
+        }
+
+        bool insert(const OutPoint &outPoint, const Coin &coin)
+        {
+            if (outPoint.n == EMPTY)
+                throw std::invalid_argument("Output index out of range");
+            if ((count + 1) * 4 > slots.size() * 3)
+                rehash(slots.size() * 2);
+
+            size_t mask = slots.size() - 1;
+            for (size_t i = hash(outPoint) & mask;; i = (i + 1) & mask)
+            {
+                Slot &slot = slots[i];
+                if (slot.n == EMPTY)
+                {
+                    slot = Slot{outPoint.txIndex, outPoint.n, coin.addr, coin.value};
+                    count++;
+                    return true;
+                }
+                if (slot.txIndex == outPoint.txIndex && slot.n == outPoint.n)
+                    return false;
+            }
+        }
+
+        // Backward-shift deletion: later entries of the probe run move up
+        // into the hole unless that would put them before their home slot
+        void erase(size_t hole)
+        {
+            size_t mask = slots.size() - 1;
+            for (size_t i = (hole + 1) & mask; slots[i].n != EMPTY; i = (i + 1) & mask)
+            {
+                size_t home = hash(OutPoint{slots[i].txIndex, slots[i].n}) & mask;
+                if (((i - home) & mask) >= ((i - hole) & mask))
+                {
+                    slots[hole] = slots[i];
+                    hole = i;
+                }
+            }
+            slots[hole] = emptySlot();
+            count--;
+        }
+
+        void rehash(size_t capacity)
+        {
+            std::vector<Slot> old(capacity, emptySlot());
+            old.swap(slots);
+
+            size_t mask = capacity - 1;
+            for (const Slot &slot : old)
+            {
+                if (slot.n == EMPTY)
+                    continue;
+                size_t i = hash(OutPoint{slot.txIndex, slot.n}) & mask;
+                while (slots[i].n != EMPTY)
+                    i = (i + 1) & mask;
+                slots[i] = slot;
+            }
+        }
+    };
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define ECHO_PROTOCOL_HPP
 
 #include "../../server/protocol/Iprotocol.hpp"
+#include "../../../global/security/HMACSHA256/HMACSHA256.hpp"
 #include <iostream>
 #include <unistd.h>
 #include <stdexcept>
@@ -22,6 +23,10 @@ namespace tin
         UNKNOWN
     };
 
+    // Set in the wire type when a TAG_LENGTH HMAC-SHA256 trailer follows
+    // the body. The tag covers the header and the body.
+    constexpr uint16_t AUTHENTICATED = 0x8000;
+
     struct ProtocolHeader
     {
         uint32_t length;
@@ -32,23 +37,31 @@ namespace tin
     class ProtocolMessage : public tin::IProtocol
     {
     public:
-        ProtocolMessage(uint16_t type, const std::string &body)
-            : type(type), body(body)
+        ProtocolMessage(uint16_t type, const std::string &body, const HMACSHA256 *auth = nullptr)
+            : type(type), body(body), auth(auth)
         {
-            length = sizeof(ProtocolHeader) + body.size();
+            length = sizeof(ProtocolHeader) + body.size() + (auth ? HMACSHA256::TAG_LENGTH : 0);
             checksum = calculate_checksum();
         }
 
         std::string serialize() const override
         {
             std::string message;
-            ProtocolHeader header = {htonl(length), htons(type), htons(checksum)};
+            uint16_t wireType = auth ? (type | AUTHENTICATED) : type;
+            ProtocolHeader header = {htonl(length), htons(wireType), htons(checksum)};
+            message.reserve(length);
             message.append(reinterpret_cast<const char *>(&header), sizeof(header));
             message.append(body);
+            if (auth)
+            {
+                auto tag = auth->mac(message);
+                message.append(reinterpret_cast<const char *>(tag.data()), tag.size());
+            }
             return message;
         }
 
-        static IProtocol *deserialize(const char *data, size_t size)
+        // With `auth`, only messages carrying a valid tag are accepted.
+        static IProtocol *deserialize(const char *data, size_t size, const HMACSHA256 *auth = nullptr)
         {
             if (size < sizeof(ProtocolHeader))
             {
@@ -67,9 +80,29 @@ namespace tin
                 throw std::runtime_error("Invalid message length");
             }
 
-            std::string body(data + sizeof(ProtocolHeader), size - sizeof(ProtocolHeader));
+            size_t bodySize = size - sizeof(ProtocolHeader);
+            bool tagged = header.type & AUTHENTICATED;
+            if (tagged != (auth != nullptr))
+            {
+                throw std::runtime_error(tagged ? "Authenticated message but no key" : "Missing message authentication");
+            }
+            if (tagged)
+            {
+                if (bodySize < HMACSHA256::TAG_LENGTH)
+                {
+                    throw std::runtime_error("Invalid message size");
+                }
+                bodySize -= HMACSHA256::TAG_LENGTH;
+                ByteView signedPart(reinterpret_cast<const uint8_t *>(data), sizeof(ProtocolHeader) + bodySize);
+                if (!auth->verify(signedPart, reinterpret_cast<const uint8_t *>(data) + signedPart.size))
+                {
+                    throw std::runtime_error("Message authentication failed");
+                }
+            }
+
+            std::string body(data + sizeof(ProtocolHeader), bodySize);
 
-            return new ProtocolMessage(header.type, body);
+            return new ProtocolMessage(header.type & ~AUTHENTICATED, body, auth);
         }
 
         uint16_t get_type() const override
@@ -82,11 +115,17 @@ namespace tin
             return body;
         }
 
+        bool is_authenticated() const
+        {
+            return auth != nullptr;
+        }
+
     private:
         uint32_t length;
         uint16_t type;
         uint16_t checksum;
         std::string body;
+        const HMACSHA256 *auth;
 
         uint16_t calculate_checksum() const
         {
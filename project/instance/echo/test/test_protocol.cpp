@@ -0,0 +1,65 @@
+#include "../echoProtocol.hpp"
+#include <cassert>
+#include <memory>
+
+void test_plainRoundTrip()
+{
+    std::string wire = tin::ProtocolMessage(tin::ECHO, "hello tin").serialize();
+    std::unique_ptr<tin::IProtocol> message(tin::ProtocolMessage::deserialize(wire.data(), wire.size()));
+
+    assert(message->get_type() == tin::ECHO);
+    assert(message->get_body() == "hello tin");
+}
+
+void test_authenticatedRoundTrip()
+{
+    tin::HMACSHA256 key(std::string("shared secret"));
+    std::string wire = tin::ProtocolMessage(tin::ECHO, "hello tin", &key).serialize();
+    assert(wire.size() == sizeof(tin::ProtocolHeader) + 9 + tin::HMACSHA256::TAG_LENGTH);
+
+    std::unique_ptr<tin::IProtocol> message(tin::ProtocolMessage::deserialize(wire.data(), wire.size(), &key));
+    assert(message->get_type() == tin::ECHO);
+    assert(message->get_body() == "hello tin");
+    assert(static_cast<tin::ProtocolMessage *>(message.get())->is_authenticated());
+
+    // A flipped body byte, a wrong key or a missing key must all be rejected
+    std::string tampered = wire;
+    tampered[sizeof(tin::ProtocolHeader)] ^= 1;
+    tin::HMACSHA256 otherKey(std::string("other secret"));
+
+    bool rejected[3] = {false, false, false};
+    try
+    {
+        delete tin::ProtocolMessage::deserialize(tampered.data(), tampered.size(), &key);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected[0] = true;
+    }
+    try
+    {
+        delete tin::ProtocolMessage::deserialize(wire.data(), wire.size(), &otherKey);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected[1] = true;
+    }
+    try
+    {
+        delete tin::ProtocolMessage::deserialize(wire.data(), wire.size());
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected[2] = true;
+    }
+    assert(rejected[0] && rejected[1] && rejected[2]);
+}
+
+int main()
+{
+    test_plainRoundTrip();
+    test_authenticatedRoundTrip();
+
+    std::cout << "All protocol tests passed" << std::endl;
+    return 0;
+}